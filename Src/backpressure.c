@@ -0,0 +1,51 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "backpressure.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define BACKPRESSURE_PATH_MAX 512
+
+static int replaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+int backpressureWrite(const char* path, const BackpressureStatus* status) {
+    char tmp[BACKPRESSURE_PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return 0;
+
+    FILE* f = fopen(tmp, "w");
+    if (!f) return 0;
+    fprintf(f, "%s %d %lld\n", BACKPRESSURE_MAGIC, BACKPRESSURE_VERSION, status->writtenAt);
+    for (int r = 0; r < 4; r++) {
+        fprintf(f, "%c %lld %d\n", 'A' + r, status->consumed[r], status->credit[r]);
+    }
+    int ok = fclose(f) == 0;
+    return ok && replaceFile(tmp, path);
+}
+
+int backpressureRead(const char* path, BackpressureStatus* out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+
+    BackpressureStatus s;
+    char magic[32];
+    int version;
+    int ok = fscanf(f, "%31s %d %lld", magic, &version, &s.writtenAt) == 3
+        && strcmp(magic, BACKPRESSURE_MAGIC) == 0 && version == BACKPRESSURE_VERSION;
+    for (int r = 0; ok && r < 4; r++) {
+        char road;
+        ok = fscanf(f, " %c %lld %d", &road, &s.consumed[r], &s.credit[r]) == 3 && road == 'A' + r;
+    }
+    fclose(f);
+
+    if (ok) *out = s;
+    return ok;
+}
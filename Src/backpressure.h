@@ -0,0 +1,28 @@
+#ifndef BACKPRESSURE_H
+#define BACKPRESSURE_H
+
+// Status file the simulator publishes for the generator, one line per road:
+//
+//   TRAFFIC-BACKPRESSURE 1 <unix seconds>
+//   A <consumed> <credit>
+//   ...
+//
+// consumed counts the records taken from the road's lane file since the file
+// was last started over; credit is how many unread records the simulator can
+// still hold for that road. A writer keeps written - consumed below credit.
+#define BACKPRESSURE_MAGIC "TRAFFIC-BACKPRESSURE"
+#define BACKPRESSURE_VERSION 1
+
+typedef struct {
+    long long consumed[4];
+    int credit[4];
+    long long writtenAt;   // unix seconds
+} BackpressureStatus;
+
+// Writes a temporary file and renames it over path, so a reader never sees
+// half a status.
+int backpressureWrite(const char* path, const BackpressureStatus* status);
+// Returns 0 if the file is missing or not a complete status.
+int backpressureRead(const char* path, BackpressureStatus* out);
+
+#endif // BACKPRESSURE_H
@@ -0,0 +1,65 @@
+#include "eventqueue.h"
+#include <stdlib.h>
+
+static int eventBefore(const SimEvent* a, const SimEvent* b) {
+    if (a->timeMs != b->timeMs) return a->timeMs < b->timeMs;
+    if (a->kind != b->kind) return a->kind < b->kind;
+    return a->index < b->index;
+}
+
+void eventQueueInitialize(EventQueue* q) {
+    q->items = NULL;
+    q->count = 0;
+    q->capacity = 0;
+}
+
+void eventQueueRelease(EventQueue* q) {
+    free(q->items);
+    eventQueueInitialize(q);
+}
+
+void eventQueueClear(EventQueue* q) {
+    q->count = 0;
+}
+
+int eventQueueReserve(EventQueue* q, int capacity) {
+    if (capacity <= q->capacity) return 1;
+    SimEvent* items = realloc(q->items, sizeof(SimEvent) * capacity);
+    if (!items) return 0;
+    q->items = items;
+    q->capacity = capacity;
+    return 1;
+}
+
+int eventQueuePush(EventQueue* q, unsigned long long timeMs, SimEventKind kind, int index) {
+    if (q->count == q->capacity && !eventQueueReserve(q, q->capacity ? q->capacity * 2 : 64)) return 0;
+
+    SimEvent e = { timeMs, kind, index };
+    int i = q->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!eventBefore(&e, &q->items[parent])) break;
+        q->items[i] = q->items[parent];
+        i = parent;
+    }
+    q->items[i] = e;
+    return 1;
+}
+
+int eventQueuePop(EventQueue* q, SimEvent* out) {
+    if (q->count == 0) return 0;
+    *out = q->items[0];
+
+    SimEvent last = q->items[--q->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= q->count) break;
+        if (child + 1 < q->count && eventBefore(&q->items[child + 1], &q->items[child])) child++;
+        if (!eventBefore(&q->items[child], &last)) break;
+        q->items[i] = q->items[child];
+        i = child;
+    }
+    if (q->count > 0) q->items[i] = last;
+    return 1;
+}
@@ -0,0 +1,32 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+// Binary min-heap of timed events for the event-driven engine. Events at the
+// same time come out in kind order, then index order, so a run does not
+// depend on the order they were pushed in.
+typedef enum {
+    SIM_EVENT_LIGHT_CHANGE,     // index = intersection
+    SIM_EVENT_METRICS,
+    SIM_EVENT_SNAPSHOT
+} SimEventKind;
+
+typedef struct {
+    unsigned long long timeMs;   // tick in which the event happens
+    SimEventKind kind;
+    int index;
+} SimEvent;
+
+typedef struct {
+    SimEvent* items;
+    int count, capacity;
+} EventQueue;
+
+void eventQueueInitialize(EventQueue* q);
+void eventQueueRelease(EventQueue* q);
+void eventQueueClear(EventQueue* q);
+// Pushes never fail while count stays within a successful reserve.
+int eventQueueReserve(EventQueue* q, int capacity);
+int eventQueuePush(EventQueue* q, unsigned long long timeMs, SimEventKind kind, int index);
+int eventQueuePop(EventQueue* q, SimEvent* out);
+
+#endif // EVENTQUEUE_H
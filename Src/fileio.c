@@ -1,66 +1,424 @@
 #include "fileio.h"
 #include "globals.h"
 #include "geometry.h"
+#include "physics.h"
 #include "queue.h"
+#include "platform.h"
+#include "vehiclelog.h"
+#include "backpressure.h"
+#include <ctype.h>
 #include <string.h>
 
-void loadVehiclesFromInputFiles() {
-    static int lastReadLines[4] = { 0, 0, 0, 0 };
+static LaneFileCursor laneCursors[4];
+static LaneLogCursor logCursors[4];
+static unsigned long long corruptLogBatches = 0;
+static char ingestBuffer[INGEST_READ_CHUNK];
+// Large enough for the biggest batch; words keep the records aligned.
+#define LOG_READ_CHUNK (sizeof(VehicleLogBatchHeader) + VEHICLE_LOG_MAX_BATCH * sizeof(VehicleLogRecord))
+static uint32_t logReadBuffer[(LOG_READ_CHUNK + 3) / 4];
 
-    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
-        FILE* f = fopen(files[roadIdx], "r");
-        if (!f) continue;
+// Records taken per road since its file was last started over; written by
+// whichever thread reads the files, read when publishing backpressure.
+static PlatformAtomicInt consumedRecords[4];
+// Only touched on the simulation thread.
+static PendingSpawnQueue pendingSpawns[4][3];
+static unsigned long long lastBackpressureNs = 0;
+
+static int deliverRecord(int roadIdx, const VehicleRecord* rec, VehicleRecordSink sink) {
+    if (!sink(roadIdx, rec)) return 0;
+    platformAtomicAdd(&consumedRecords[roadIdx], 1);
+    return 1;
+}
+
+static void resetLaneCursor(LaneFileCursor* c) {
+    c->offset = 0;
+    c->signatureLength = 0;
+}
+
+static long measureFileSize(FILE* f) {
+    if (fseek(f, 0, SEEK_END) != 0) return -1;
+    return ftell(f);
+}
+
+static int cursorSignatureMatches(FILE* f, const LaneFileCursor* c) {
+    if (c->signatureLength == 0) return 1;
+
+    char head[INGEST_SIGNATURE_BYTES];
+    if (fseek(f, 0, SEEK_SET) != 0) return 0;
+    if (fread(head, 1, c->signatureLength, f) != (size_t)c->signatureLength) return 0;
+    return memcmp(head, c->signature, c->signatureLength) == 0;
+}
+
+static void captureCursorSignature(FILE* f, LaneFileCursor* c) {
+    long wanted = c->offset < INGEST_SIGNATURE_BYTES ? c->offset : INGEST_SIGNATURE_BYTES;
+    if (c->signatureLength >= wanted) return;
+    if (fseek(f, 0, SEEK_SET) != 0) return;
+    c->signatureLength = (int)fread(c->signature, 1, (size_t)wanted, f);
+}
 
-        char line[128];
-        int currentLine = 0;
+static int parseVehicleRecord(char* line, VehicleRecord* out) {
+    char* cursor;
+    long id = strtol(line, &cursor, 10);
+    if (cursor == line) return 0;
 
-        while (currentLine < lastReadLines[roadIdx] && fgets(line, sizeof(line), f)) {
-            currentLine++;
+    while (*cursor == ' ' || *cursor == '\t') cursor++;
+    int nameLength = 0;
+    while (cursor[nameLength] && !isspace((unsigned char)cursor[nameLength])) nameLength++;
+    if (nameLength == 0) return 0;
+
+    char* laneEnd;
+    long lane = strtol(cursor + nameLength, &laneEnd, 10);
+    if (laneEnd == cursor + nameLength) return 0;
+
+    if (nameLength > NAME_MAX - 1) nameLength = NAME_MAX - 1;
+    memcpy(out->name, cursor, nameLength);
+    out->name[nameLength] = '\0';
+    out->id = (int)id;
+    out->lane = (int)lane;
+    return 1;
+}
+
+// Parses every complete line in [0, length) and returns how many bytes were
+// consumed; a trailing line without '\n' is left for the next poll, and so is
+// a line the sink refuses (*refused is then set).
+static long parseRecordChunk(int roadIdx, char* chunk, long length, VehicleRecordSink sink, int* refused) {
+    char* lineStart = chunk;
+    char* end = chunk + length;
+
+    for (;;) {
+        char* newline = memchr(lineStart, '\n', end - lineStart);
+        if (!newline) break;
+        *newline = '\0';
+
+        VehicleRecord rec;
+        if (parseVehicleRecord(lineStart, &rec) && !deliverRecord(roadIdx, &rec, sink)) {
+            *refused = 1;
+            break;
         }
+        lineStart = newline + 1;
+    }
 
-        while (fgets(line, sizeof(line), f)) {
-            int id, lane;
-            char name[NAME_MAX];
+    return (long)(lineStart - chunk);
+}
 
-            if (sscanf(line, "%d %15s %d", &id, name, &lane) == 3) {
-                Vehicle v;
-                v.id = id;
-                v.fromRoad = roadIdx;
-                v.isStopped = 0;
-                strncpy(v.name, name, NAME_MAX - 1);
-                v.name[NAME_MAX - 1] = '\0';
+static void readAppendedRecords(FILE* f, int roadIdx, LaneFileCursor* c, long size, VehicleRecordSink sink) {
+    while (c->offset < size) {
+        long wanted = size - c->offset;
+        if (wanted > INGEST_READ_CHUNK) wanted = INGEST_READ_CHUNK;
+        if (fseek(f, c->offset, SEEK_SET) != 0) return;
 
-                Lane* targetLane = NULL;
-                int laneIndex = 0;
+        long got = (long)fread(ingestBuffer, 1, (size_t)wanted, f);
+        if (got <= 0) return;
 
-                if (lane == 1) {
-                    targetLane = &roads[roadIdx].L1;
-                    laneIndex = mapLogicalLaneToPhysical(roadIdx, 1);
-                }
-                else if (lane == 2) {
-                    targetLane = &roads[roadIdx].L2;
-                    laneIndex = mapLogicalLaneToPhysical(roadIdx, 2);
-                }
-                else if (lane == 3) {
-                    targetLane = &roads[roadIdx].L3;
-                    laneIndex = mapLogicalLaneToPhysical(roadIdx, 3);
-                }
+        int refused = 0;
+        long consumed = parseRecordChunk(roadIdx, ingestBuffer, got, sink, &refused);
+        if (refused) {
+            c->offset += consumed;
+            return;
+        }
+        if (consumed == 0) {
+            // A full chunk without a newline can never complete; skip it.
+            if (got < INGEST_READ_CHUNK) return;
+            consumed = got;
+        }
+        c->offset += consumed;
+    }
+}
+
+static void resetLogCursor(LaneLogCursor* c, uint32_t sessionId) {
+    c->offset = sizeof(VehicleLogHeader);
+    c->sessionId = sessionId;
+    c->stalled = 0;
+    c->delivered = 0;
+}
+
+void vehicleRecordFromLog(const VehicleLogRecord* in, VehicleRecord* out) {
+    out->id = in->id;
+    out->lane = in->lane;
+    memcpy(out->name, in->name, NAME_MAX - 1);
+    out->name[NAME_MAX - 1] = '\0';
+}
+
+// Returns 0 if the sink refused a record; c->delivered says where to resume.
+static int deliverLogBatch(int roadIdx, LaneLogCursor* c, const VehicleLogRecord* records, int count, VehicleRecordSink sink) {
+    for (; c->delivered < count; c->delivered++) {
+        VehicleRecord rec;
+        vehicleRecordFromLog(&records[c->delivered], &rec);
+        if (!deliverRecord(roadIdx, &rec, sink)) return 0;
+    }
+    return 1;
+}
+
+static void readAppendedBatches(FILE* f, int roadIdx, LaneLogCursor* c, long long size, VehicleRecordSink sink) {
+    while (!c->stalled && (long long)c->offset < size) {
+        size_t base = c->offset;
+        size_t wanted = (size_t)(size - (long long)base);
+        if (wanted > LOG_READ_CHUNK) wanted = LOG_READ_CHUNK;
+        if (fseek(f, (long)base, SEEK_SET) != 0) return;
+
+        size_t got = fread(logReadBuffer, 1, wanted, f);
+        size_t local = 0;
+        for (;;) {
+            const VehicleLogRecord* records;
+            int count;
+            size_t next = local;
 
-                if (targetLane) {
-                    float sx, sy;
-                    calculateSpawnPosition(roadIdx, laneIndex, &sx, &sy);
-                    v.x = sx;
-                    v.y = sy;
+            VehicleLogStatus status = vehicleLogNextBatch(logReadBuffer, got, &next, &records, &count);
+            if (status == VEHICLE_LOG_INCOMPLETE) break;
 
-                    if (!detectCollisionInLane(targetLane, sx, sy, -1)) {
-                        queueInsert(targetLane, v);
-                    }
+            if (status == VEHICLE_LOG_CORRUPT) {
+                if (next == local) {
+                    // Bad batch header: nothing after it can be trusted.
+                    c->stalled = 1;
+                    corruptLogBatches++;
+                    return;
                 }
+                // The last batch may still be landing; check it again next poll.
+                if (base + next == (size_t)size) return;
+                corruptLogBatches++;
+                c->offset = base + next;
+                local = next;
+                continue;
             }
 
-            lastReadLines[roadIdx]++;
+            if (!deliverLogBatch(roadIdx, c, records, count, sink)) return;
+            c->offset = base + next;
+            c->delivered = 0;
+            local = next;
+        }
+        // A chunk holds a whole batch, so one that yields nothing is still
+        // being written (or the file was cut short under us).
+        if (local == 0) return;
+    }
+}
+
+// Returns 0 when the road has no binary log, so the text file is used.
+// The log is read rather than mapped: the generator truncates it on restart,
+// which would fault a live mapping here and fail outright on Windows.
+static int pollLaneLog(int roadIdx, VehicleRecordSink sink) {
+    long long size = platformFileSize(logFiles[roadIdx]);
+    if (size < 0) return 0;
+
+    LaneLogCursor* c = &logCursors[roadIdx];
+    if (c->offset != 0 && (size_t)size == c->offset) return 1;
+
+    FILE* f = fopen(logFiles[roadIdx], "rb");
+    if (!f) return 1;
+
+    unsigned char head[sizeof(VehicleLogHeader)];
+    size_t headLength = fread(head, 1, sizeof(head), f);
+    size = measureFileSize(f);
+
+    VehicleLogHeader header;
+    if (size >= 0 && vehicleLogReadHeader(head, headLength, &header) == VEHICLE_LOG_OK) {
+        if (c->offset == 0 || header.sessionId != c->sessionId || (size_t)size < c->offset) {
+            resetLogCursor(c, header.sessionId);
+            platformAtomicStore(&consumedRecords[roadIdx], 0);
+        }
+        readAppendedBatches(f, roadIdx, c, size, sink);
+    }
+
+    fclose(f);
+    return 1;
+}
+
+// Returns 0 when the spawn point is occupied (or the lane is invalid).
+// spawnMs is when the vehicle first entered the network; it joins the lane now.
+int spawnVehicleFromRecord(Intersection* in, int roadIdx, const VehicleRecord* rec, unsigned int spawnMs) {
+    RoadData* roads = in->roads;
+    Vehicle v;
+    v.id = rec->id;
+    v.fromRoad = roadIdx;
+    v.isStopped = 0;
+    strncpy(v.name, rec->name, NAME_MAX - 1);
+    v.name[NAME_MAX - 1] = '\0';
+    v.times.spawnMs = spawnMs;
+    v.times.laneMs = (unsigned int)simulationTimeMs;
+    v.times.firstStopMs = VEHICLE_TIME_UNSET;
+    v.times.entryMs = VEHICLE_TIME_UNSET;
+
+    Lane* targetLane = NULL;
+    int laneIndex = 0;
+
+    if (rec->lane == 1) {
+        targetLane = &roads[roadIdx].L1;
+        laneIndex = mapLogicalLaneToPhysical(roadIdx, 1);
+    }
+    else if (rec->lane == 2) {
+        targetLane = &roads[roadIdx].L2;
+        laneIndex = mapLogicalLaneToPhysical(roadIdx, 2);
+    }
+    else if (rec->lane == 3) {
+        targetLane = &roads[roadIdx].L3;
+        laneIndex = mapLogicalLaneToPhysical(roadIdx, 3);
+    }
+
+    if (targetLane) {
+        float sx, sy;
+        calculateSpawnPosition(roadIdx, laneIndex, &sx, &sy);
+        v.x = sx;
+        v.y = sy;
+
+        if (!detectCollisionInLane(targetLane, sx, sy, -1)) {
+            return queueInsert(targetLane, v);
+        }
+    }
+    return 0;
+}
+
+// External input (lane files, ingest, replay) enters the network at the
+// first intersection. An arrival whose spawn point is occupied, or whose lane
+// already has arrivals waiting, joins that lane's pending buffer. Returns 0
+// only when that buffer is full, so the caller must keep the record.
+int spawnAtNetworkEntry(int roadIdx, const VehicleRecord* rec) {
+    Intersection* entry = &network.cells[0];
+    if (rec->lane < 1 || rec->lane > 3) {
+        // Taken so the reader moves past it, but counted rather than lost.
+        metricsRecordDrop(&entry->metrics, METRICS_DROP_INVALID);
+        return 1;
+    }
+
+    PendingSpawnQueue* q = &pendingSpawns[roadIdx][rec->lane - 1];
+    unsigned int now = (unsigned int)simulationTimeMs;
+    if (q->count == 0 && spawnVehicleFromRecord(entry, roadIdx, rec, now)) {
+        metricsRecordSpawn(&entry->metrics, 0);
+        return 1;
+    }
+    if (q->count == PENDING_SPAWN_CAPACITY) return 0;
+
+    PendingSpawn* p = &q->items[(q->head + q->count) % PENDING_SPAWN_CAPACITY];
+    p->rec = *rec;
+    p->arrivalMs = now;
+    q->count++;
+    metricsRecordDeferred(&entry->metrics);
+    return 1;
+}
+
+// Runs before new input each tick so arrivals keep their order per lane.
+// The journey starts at arrival, not when the spawn point cleared.
+void spawnPendingVehicles(void) {
+    Intersection* entry = &network.cells[0];
+    unsigned int now = (unsigned int)simulationTimeMs;
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        for (int k = 0; k < 3; k++) {
+            PendingSpawnQueue* q = &pendingSpawns[roadIdx][k];
+            while (q->count > 0) {
+                PendingSpawn* p = &q->items[q->head];
+                if (!spawnVehicleFromRecord(entry, roadIdx, &p->rec, p->arrivalMs)) break;
+                metricsRecordSpawn(&entry->metrics, now - p->arrivalMs);
+                q->head = (q->head + 1) % PENDING_SPAWN_CAPACITY;
+                q->count--;
+            }
+        }
+    }
+}
+
+int countPendingSpawns(void) {
+    int total = 0;
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        for (int k = 0; k < 3; k++) total += pendingSpawns[roadIdx][k].count;
+    }
+    return total;
+}
+
+// A road's credit is the free space of its fullest pending buffer, since one
+// blocked lane holds up the rest of that road's file. Throttled on wall time,
+// which is what the generator runs on.
+void publishInputBackpressure(void) {
+    if (!backpressureFile[0]) return;
+    unsigned long long now = platformNowNs();
+    if (lastBackpressureNs != 0 && now - lastBackpressureNs < BACKPRESSURE_PUBLISH_MS * 1000000ULL) return;
+    lastBackpressureNs = now;
+
+    BackpressureStatus s;
+    s.writtenAt = (long long)time(NULL);
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        int credit = PENDING_SPAWN_CAPACITY;
+        for (int k = 0; k < 3; k++) {
+            int room = PENDING_SPAWN_CAPACITY - pendingSpawns[roadIdx][k].count;
+            if (room < credit) credit = room;
+        }
+        s.consumed[roadIdx] = platformAtomicLoad(&consumedRecords[roadIdx]);
+        s.credit[roadIdx] = credit;
+    }
+    backpressureWrite(backpressureFile, &s);
+}
+
+void pollLaneFiles(VehicleRecordSink sink) {
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        if (pollLaneLog(roadIdx, sink)) continue;
+
+        FILE* f = fopen(files[roadIdx], "rb");
+        if (!f) continue;
+
+        LaneFileCursor* c = &laneCursors[roadIdx];
+        long size = measureFileSize(f);
+        if (size < 0) {
+            fclose(f);
+            continue;
+        }
+
+        // Shrunk or rewritten (e.g. the generator cleared it): start over.
+        if (size < c->offset || !cursorSignatureMatches(f, c)) {
+            resetLaneCursor(c);
+            platformAtomicStore(&consumedRecords[roadIdx], 0);
+        }
+
+        if (size > c->offset) {
+            readAppendedRecords(f, roadIdx, c, size, sink);
+            captureCursorSignature(f, c);
         }
 
         fclose(f);
     }
 }
+
+// Next poll starts every file from the top, as at program start, with
+// nothing waiting to spawn.
+void resetInputCursors(void) {
+    memset(laneCursors, 0, sizeof(laneCursors));
+    memset(logCursors, 0, sizeof(logCursors));
+    memset(pendingSpawns, 0, sizeof(pendingSpawns));
+    for (int i = 0; i < 4; i++) platformAtomicStore(&consumedRecords[i], 0);
+    lastBackpressureNs = 0;
+}
+
+// Read positions and waiting spawns, so a restored run picks the input files
+// up where the saved one stopped.
+void inputSaveSnapshot(SnapshotBuffer* out) {
+    snapshotPut(out, laneCursors, sizeof(laneCursors));
+    snapshotPut(out, logCursors, sizeof(logCursors));
+    snapshotPut(out, pendingSpawns, sizeof(pendingSpawns));
+    for (int i = 0; i < 4; i++) {
+        long consumed = platformAtomicLoad(&consumedRecords[i]);
+        snapshotPut(out, &consumed, sizeof(consumed));
+    }
+}
+
+int inputLoadSnapshot(SnapshotReader* in) {
+    resetInputCursors();
+    int ok = snapshotGet(in, laneCursors, sizeof(laneCursors))
+        && snapshotGet(in, logCursors, sizeof(logCursors))
+        && snapshotGet(in, pendingSpawns, sizeof(pendingSpawns));
+    for (int i = 0; ok && i < 4; i++) {
+        long consumed;
+        ok = snapshotGet(in, &consumed, sizeof(consumed));
+        if (ok) platformAtomicStore(&consumedRecords[i], consumed);
+    }
+    for (int r = 0; ok && r < 4; r++) {
+        for (int k = 0; k < 3; k++) {
+            const PendingSpawnQueue* q = &pendingSpawns[r][k];
+            if (q->head < 0 || q->head >= PENDING_SPAWN_CAPACITY || q->count < 0 || q->count > PENDING_SPAWN_CAPACITY) ok = 0;
+        }
+    }
+    if (!ok) resetInputCursors();
+    return ok;
+}
+
+void loadVehiclesFromInputFiles() {
+    pollLaneFiles(spawnAtNetworkEntry);
+}
+
+unsigned long long countCorruptLogBatches(void) {
+    return corruptLogBatches;
+}
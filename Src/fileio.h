@@ -2,7 +2,55 @@
 #define FILEIO_H
 
 #include "types.h"
+#include "vehiclelog.h"
+#include "snapshot.h"
+#include <stdint.h>
 
+// Byte position of the next unread record in a lane file, plus the first
+// consumed bytes so a truncated or replaced file can be detected.
+typedef struct {
+    long offset;
+    int signatureLength;
+    char signature[INGEST_SIGNATURE_BYTES];
+} LaneFileCursor;
+
+// Read position in a binary lane log (see vehiclelog.h). The session id ties
+// the cursor to one log instance so a restarted generator is noticed.
+typedef struct {
+    size_t offset;
+    uint32_t sessionId;
+    int stalled;
+    int delivered;   // records of the batch at offset already taken
+} LaneLogCursor;
+
+// Arrivals waiting for their spawn point to clear, oldest first.
+typedef struct {
+    VehicleRecord rec;
+    unsigned int arrivalMs;
+} PendingSpawn;
+
+typedef struct {
+    PendingSpawn items[PENDING_SPAWN_CAPACITY];
+    int head;
+    int count;
+} PendingSpawnQueue;
+
+// Receives each parsed record; lets the reader run on another thread.
+// Returns 0 when it has no room, and the reader offers the same record again
+// on its next poll.
+typedef int (*VehicleRecordSink)(int roadIdx, const VehicleRecord* rec);
+
+void pollLaneFiles(VehicleRecordSink sink);
 void loadVehiclesFromInputFiles(void);
+void resetInputCursors(void);
+unsigned long long countCorruptLogBatches(void);
+void vehicleRecordFromLog(const VehicleLogRecord* in, VehicleRecord* out);
+int spawnVehicleFromRecord(Intersection* in, int roadIdx, const VehicleRecord* rec, unsigned int spawnMs);
+int spawnAtNetworkEntry(int roadIdx, const VehicleRecord* rec);
+void spawnPendingVehicles(void);
+int countPendingSpawns(void);
+void publishInputBackpressure(void);
+void inputSaveSnapshot(SnapshotBuffer* out);
+int inputLoadSnapshot(SnapshotReader* in);
 
 #endif // FILEIO_H
@@ -7,50 +7,46 @@ float calculateDistance(float x1, float y1, float x2, float y2) {
     return sqrtf(dx * dx + dy * dy);
 }
 
+#define ROAD_CX (SCREEN_W / 2.0f)
+#define ROAD_CY (SCREEN_H / 2.0f)
+#define ROAD_LEFT (ROAD_CX - ROAD_W / 2.0f)
+#define ROAD_TOP (ROAD_CY - ROAD_W / 2.0f)
+
+const RoadTraits roadTraits[4] = {
+    // north, driving down
+    { 0.0f, 1.0f, 1.0f, 0.0f, ROAD_LEFT, -30.0f, ROAD_LEFT, ROAD_CY - ROAD_W / 2.0f - 8.0f,
+      ROAD_CY - ROAD_W / 2.0f, { 2, 2, 1, 0 } },
+    // east, driving left
+    { -1.0f, 0.0f, 0.0f, 1.0f, SCREEN_W + 30.0f, ROAD_TOP, ROAD_CX + ROAD_W / 2.0f + 8.0f, ROAD_TOP,
+      -(ROAD_CX + ROAD_W / 2.0f), { 2, 2, 1, 0 } },
+    // south, driving up
+    { 0.0f, -1.0f, 1.0f, 0.0f, ROAD_LEFT, SCREEN_H + 30.0f, ROAD_LEFT, ROAD_CY + ROAD_W / 2.0f + 8.0f,
+      -(ROAD_CY + ROAD_W / 2.0f), { 0, 0, 1, 2 } },
+    // west, driving right
+    { 1.0f, 0.0f, 0.0f, 1.0f, -30.0f, ROAD_TOP, ROAD_CX - ROAD_W / 2.0f - 8.0f, ROAD_TOP,
+      ROAD_CX - ROAD_W / 2.0f, { 0, 0, 1, 2 } }
+};
+
+float measureRoadProgress(const RoadTraits* t, float x, float y) {
+    return t->alongX * x + t->alongY * y;
+}
+
+// Anything but lanes 2 and 3 maps like lane 1.
 int mapLogicalLaneToPhysical(int road, int logicalLane) {
-    if (road == 0) {
-        if (logicalLane == 3) return 0;
-        if (logicalLane == 2) return 1;
-        return 2;
-    }
-    else if (road == 1) {
-        if (logicalLane == 3) return 0;
-        if (logicalLane == 2) return 1;
-        return 2;
-    }
-    else if (road == 2) {
-        if (logicalLane == 3) return 2;
-        if (logicalLane == 2) return 1;
-        return 0;
-    }
-    else {
-        if (logicalLane == 3) return 2;
-        if (logicalLane == 2) return 1;
-        return 0;
-    }
+    if (logicalLane < 0 || logicalLane > 3) logicalLane = 0;
+    return roadTraits[road].physicalLane[logicalLane];
 }
 
 void calculateSpawnPosition(int road, int laneIndex, float* outx, float* outy) {
-    float cx = SCREEN_W / 2.0f;
-    float cy = SCREEN_H / 2.0f;
-    float startx = cx - ROAD_W / 2.0f;
-    float starty = cy - ROAD_W / 2.0f;
-
-    if (road == 0) { *outx = startx + LANE_W * (laneIndex + 0.5f); *outy = -30.0f; }
-    else if (road == 1) { *outx = SCREEN_W + 30.0f; *outy = starty + LANE_W * (laneIndex + 0.5f); }
-    else if (road == 2) { *outx = startx + LANE_W * (laneIndex + 0.5f); *outy = SCREEN_H + 30.0f; }
-    else { *outx = -30.0f; *outy = starty + LANE_W * (laneIndex + 0.5f); }
+    const RoadTraits* t = &roadTraits[road];
+    float offset = LANE_W * (laneIndex + 0.5f);
+    *outx = t->spawnX + t->acrossX * offset;
+    *outy = t->spawnY + t->acrossY * offset;
 }
 
 void calculateIntersectionLaneCenter(int road, int logicalLane, float* outx, float* outy) {
-    float cx = SCREEN_W / 2.0f;
-    float cy = SCREEN_H / 2.0f;
-    float startx = cx - ROAD_W / 2.0f;
-    float starty = cy - ROAD_W / 2.0f;
-
-    int idx = mapLogicalLaneToPhysical(road, logicalLane);
-    if (road == 0) { *outx = startx + LANE_W * (idx + 0.5f); *outy = cy - ROAD_W / 2.0f - 8.0f; }
-    else if (road == 1) { *outx = cx + ROAD_W / 2.0f + 8.0f; *outy = starty + LANE_W * (idx + 0.5f); }
-    else if (road == 2) { *outx = startx + LANE_W * (idx + 0.5f); *outy = cy + ROAD_W / 2.0f + 8.0f; }
-    else { *outx = cx - ROAD_W / 2.0f - 8.0f; *outy = starty + LANE_W * (idx + 0.5f); }
+    const RoadTraits* t = &roadTraits[road];
+    float offset = LANE_W * (mapLogicalLaneToPhysical(road, logicalLane) + 0.5f);
+    *outx = t->centerX + t->acrossX * offset;
+    *outy = t->centerY + t->acrossY * offset;
 }
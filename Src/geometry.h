@@ -3,7 +3,24 @@
 
 #include "types.h"
 
+// Direction constants for each road, so per-vehicle code looks them up once
+// instead of branching on the road. Progress along the inbound road is
+// alongX * x + alongY * y; inbound traffic gains VEHICLE_SPEED of progress
+// per tick and L3 traffic loses it. Physical lane k sits
+// LANE_W * (k + 0.5) from an origin along (acrossX, acrossY).
+typedef struct {
+    float alongX, alongY;
+    float acrossX, acrossY;
+    float spawnX, spawnY;     // lane origin where inbound traffic enters the frame
+    float centerX, centerY;   // lane origin at the mouth of the intersection
+    float stopLine;           // progress at the mouth of the intersection
+    int physicalLane[4];      // logical lane 1-3 -> physical index
+} RoadTraits;
+
+extern const RoadTraits roadTraits[4];
+
 float calculateDistance(float x1, float y1, float x2, float y2);
+float measureRoadProgress(const RoadTraits* t, float x, float y);
 int mapLogicalLaneToPhysical(int road, int logicalLane);
 void calculateSpawnPosition(int road, int laneIndex, float* outx, float* outy);
 void calculateIntersectionLaneCenter(int road, int logicalLane, float* outx, float* outy);
@@ -2,14 +2,14 @@
 #define GLOBALS_H
 
 #include "types.h"
+#include "intersection.h"
 
-extern RoadData roads[4];
-extern TransitionVehicle transitions[MAX_QUEUE];
-extern int transitionCount;
-extern int currentGreen;
-extern int lightState;
+extern IntersectionGrid network;
+extern unsigned long long simulationTimeMs;
 
 extern const char* basedir;
 extern const char* files[4];
+extern const char* logFiles[4];
+extern const char* backpressureFile;
 
 #endif // GLOBALS_H
@@ -0,0 +1,61 @@
+#include "histogram.h"
+
+static int highestBit(unsigned long long v) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+static int bucketFor(unsigned long long value) {
+    if (value < 16) return (int)value;
+    int exp = highestBit(value);
+    int index = 16 + (exp - 4) * 8 + (int)((value >> (exp - 3)) & 7);
+    return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+// Midpoint of a bucket's range.
+static double bucketValue(int index) {
+    if (index < 16) return index;
+    int exp = 4 + (index - 16) / 8;
+    int sub = (index - 16) % 8;
+    double width = (double)(1ULL << (exp - 3));
+    return (8 + sub) * width + width / 2.0;
+}
+
+void histogramRecord(Histogram* h, unsigned long long value) {
+    h->buckets[bucketFor(value)]++;
+    h->count++;
+    h->total += value;
+    if (value > h->max) h->max = value;
+}
+
+void histogramMerge(Histogram* into, const Histogram* from) {
+    if (from->count == 0) return;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) into->buckets[b] += from->buckets[b];
+    into->count += from->count;
+    into->total += from->total;
+    if (from->max > into->max) into->max = from->max;
+}
+
+// Never reports more than the recorded maximum.
+double histogramPercentile(const Histogram* h, double fraction) {
+    if (h->count == 0) return 0.0;
+    unsigned long long rank = (unsigned long long)(fraction * (h->count - 1)) + 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            double value = bucketValue(b);
+            return value < (double)h->max ? value : (double)h->max;
+        }
+    }
+    return (double)h->max;
+}
+
+double histogramMean(const Histogram* h) {
+    return h->count ? (double)h->total / h->count : 0.0;
+}
@@ -0,0 +1,23 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "config.h"
+
+// Log-linear histogram: exact below 16, then 8 buckets per power of two, so
+// any percentile is within 12.5% of the true value. Values past ~2^37 share
+// the top bucket. Recording is a few instructions and never allocates.
+#define HISTOGRAM_BUCKETS 280
+
+typedef struct {
+    unsigned int buckets[HISTOGRAM_BUCKETS];
+    unsigned long long count;
+    unsigned long long total;
+    unsigned long long max;
+} Histogram;
+
+void histogramRecord(Histogram* h, unsigned long long value);
+void histogramMerge(Histogram* into, const Histogram* from);
+double histogramPercentile(const Histogram* h, double fraction);
+double histogramMean(const Histogram* h);
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,149 @@
+#include "ingest.h"
+#include "fileio.h"
+
+#define INGEST_RING_MASK (INGEST_RING_CAPACITY - 1)
+#define INGEST_STOP_POLL_MS 10
+
+static IngestRing rings[4];
+static PlatformThread ingestThread;
+static PlatformAtomicInt stopRequested;
+static int running = 0;
+static unsigned long long delivered = 0;
+static VehicleRing sharedRing;
+static int sharedRingOpen = 0;
+
+static void resetIngestRing(IngestRing* r) {
+    r->head = 0;
+    r->tail = 0;
+    r->highWater = 0;
+    r->stalls = 0;
+}
+
+// Producer side; when the ring is full the reader stops and offers the
+// record again on its next poll.
+static int ingestRingPush(IngestRing* r, const VehicleRecord* rec) {
+    long tail = r->tail;
+    long head = platformAtomicLoad(&r->head);
+    long next = (tail + 1) & INGEST_RING_MASK;
+    if (next == head) {
+        platformAtomicAdd(&r->stalls, 1);
+        return 0;
+    }
+
+    r->records[tail] = *rec;
+    platformAtomicStore(&r->tail, next);
+
+    long used = (next - head) & INGEST_RING_MASK;
+    if (used > r->highWater) platformAtomicStore(&r->highWater, used);
+    return 1;
+}
+
+// Consumer side: the front record stays in the ring until ingestRingPop().
+static const VehicleRecord* ingestRingPeek(IngestRing* r) {
+    long head = r->head;
+    if (head == platformAtomicLoad(&r->tail)) return NULL;
+    return &r->records[head];
+}
+
+static void ingestRingPop(IngestRing* r) {
+    platformAtomicStore(&r->head, (r->head + 1) & INGEST_RING_MASK);
+}
+
+static int enqueueRecord(int roadIdx, const VehicleRecord* rec) {
+    return ingestRingPush(&rings[roadIdx], rec);
+}
+
+static void runIngestThread(void* arg) {
+    (void)arg;
+    while (!platformAtomicLoad(&stopRequested)) {
+        pollLaneFiles(enqueueRecord);
+
+        // Sleep in short slices so a stop request is honoured promptly.
+        for (int waited = 0; waited < FILE_POLL_INTERVAL_MS; waited += INGEST_STOP_POLL_MS) {
+            if (platformAtomicLoad(&stopRequested)) break;
+            sleep_ms(INGEST_STOP_POLL_MS);
+        }
+    }
+}
+
+int ingestStart(void) {
+    if (running) return 1;
+
+    for (int i = 0; i < 4; i++) resetIngestRing(&rings[i]);
+    delivered = 0;
+    platformAtomicStore(&stopRequested, 0);
+
+    if (!platformThreadCreate(&ingestThread, runIngestThread, NULL)) return 0;
+    running = 1;
+    return 1;
+}
+
+void ingestStop(void) {
+    if (!running) return;
+    platformAtomicStore(&stopRequested, 1);
+    platformThreadJoin(ingestThread);
+    running = 0;
+
+    // Deliver whatever the thread produced before it stopped.
+    ingestDrain();
+}
+
+int ingestIsRunning(void) {
+    return running;
+}
+
+int ingestDrain(void) {
+    int count = 0;
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        // A record the entry cannot hold yet stays at the front of its ring.
+        const VehicleRecord* rec;
+        while ((rec = ingestRingPeek(&rings[roadIdx])) && spawnAtNetworkEntry(roadIdx, rec)) {
+            ingestRingPop(&rings[roadIdx]);
+            count++;
+        }
+    }
+    delivered += count;
+    return count;
+}
+
+int ingestOpenSharedRing(const char* name) {
+    if (sharedRingOpen) return 1;
+    sharedRingOpen = vehicleRingCreate(&sharedRing, name);
+    return sharedRingOpen;
+}
+
+void ingestCloseSharedRing(void) {
+    if (!sharedRingOpen) return;
+    vehicleRingClose(&sharedRing);
+    sharedRingOpen = 0;
+}
+
+int ingestSharedRingActive(void) {
+    return sharedRingOpen;
+}
+
+// Records are taken straight from the mapping; one the entry cannot hold
+// yet stays in the ring, which in turn holds up the generator.
+int ingestDrainSharedRing(void) {
+    int count = 0;
+    for (int roadIdx = 0; roadIdx < 4; roadIdx++) {
+        const VehicleLogRecord* r;
+        while ((r = vehicleRingPeek(&sharedRing, roadIdx))) {
+            VehicleRecord rec;
+            vehicleRecordFromLog(r, &rec);
+            if (!spawnAtNetworkEntry(roadIdx, &rec)) break;
+            vehicleRingRelease(&sharedRing, roadIdx);
+            count++;
+        }
+    }
+    delivered += count;
+    return count;
+}
+
+void ingestGetStats(IngestStats* out) {
+    for (int i = 0; i < 4; i++) {
+        out->highWater[i] = platformAtomicLoad(&rings[i].highWater);
+        out->stalls[i] = platformAtomicLoad(&rings[i].stalls);
+    }
+    out->delivered = delivered;
+}
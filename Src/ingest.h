@@ -0,0 +1,38 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "types.h"
+#include "platform.h"
+#include "vehiclering.h"
+
+// Bounded single-producer/single-consumer ring of parsed records for one
+// road. The ingest thread only writes tail, the simulation only writes head;
+// one slot stays empty so full and empty can be told apart.
+typedef struct {
+    VehicleRecord records[INGEST_RING_CAPACITY];
+    PlatformAtomicInt head;
+    PlatformAtomicInt tail;
+    PlatformAtomicInt highWater;
+    PlatformAtomicInt stalls;
+} IngestRing;
+
+typedef struct {
+    long highWater[4];
+    long stalls[4];   // polls that stopped reading because the ring was full
+    unsigned long long delivered;
+} IngestStats;
+
+int ingestStart(void);
+void ingestStop(void);
+int ingestIsRunning(void);
+int ingestDrain(void);
+void ingestGetStats(IngestStats* out);
+
+// Shared-memory input (see vehiclering.h), read in place by the tick instead
+// of polling the lane files. Opened once per process.
+int ingestOpenSharedRing(const char* name);
+void ingestCloseSharedRing(void);
+int ingestSharedRingActive(void);
+int ingestDrainSharedRing(void);
+
+#endif // INGEST_H
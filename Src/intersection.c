@@ -0,0 +1,330 @@
+#include "intersection.h"
+#include "queue.h"
+#include "physics.h"
+#include "transition.h"
+#include "fileio.h"
+#include "geometry.h"
+#include "profiler.h"
+
+static int hasReachedIntersection(const RoadTraits* t, float x, float y) {
+    return measureRoadProgress(t, x, y) >= t->stopLine;
+}
+
+static int transitionPoolIsFull(const Intersection* in) {
+    return in->transitions.count >= MAX_TRANSITIONS;
+}
+
+// Callers check transitionPoolIsFull() first, so the insert cannot fail.
+static void enterIntersection(Intersection* in, Lane* L, int i, int targetRoad, int lane, unsigned long long nowMs) {
+    Vehicle temp;
+    queueMarkRemoved(L, i, &temp);
+    metricsRecordEntry(&in->metrics, in->currentGreen, lane, &temp, nowMs);
+    insertVehicleIntoTransition(&in->transitions, temp, targetRoad);
+    in->stats.vehiclesEntered++;
+    signalControllerRecordCleared(&in->signal, 1);
+}
+
+static void handOffGreenLightVehicles(Intersection* in, unsigned long long nowMs) {
+    int green = in->currentGreen;
+    if (green < 0 || green >= 4 || in->lightState != GREEN_LIGHT) return;
+
+    // A full transition area keeps vehicles at the stop line until a slot frees.
+
+    // left-turn lane
+    Lane* L = &in->roads[green].L1;
+    for (int i = 0; i < L->count; i++) {
+        int v = QUEUE_SLOT(L, i);
+        if (L->isRemoved[v]) continue;
+
+        if (hasReachedIntersection(&roadTraits[green], L->x[v], L->y[v])) {
+            if (transitionPoolIsFull(in)) return;
+            enterIntersection(in, L, i, (green + 1) % 4, 1, nowMs);
+        }
+    }
+
+    // straight lane
+    L = &in->roads[green].L2;
+    for (int i = 0; i < L->count; i++) {
+        int v = QUEUE_SLOT(L, i);
+        if (L->isRemoved[v]) continue;
+
+        if (hasReachedIntersection(&roadTraits[green], L->x[v], L->y[v])) {
+            if (transitionPoolIsFull(in)) return;
+            int opposite = (green + 2) % 4;
+            int targetRoad = simRandomRange(&in->random, 0, 1) == 0 ? opposite : (green + 3) % 4;
+            enterIntersection(in, L, i, targetRoad, 2, nowMs);
+        }
+    }
+}
+
+void intersectionInitialize(Intersection* in, unsigned long long seed, SignalPolicy policy, const SignalPriority* priority) {
+    for (int r = 0; r < 4; r++) {
+        queueInitialize(&in->roads[r].L1);
+        queueInitialize(&in->roads[r].L2);
+        queueInitialize(&in->roads[r].L3);
+    }
+    transitionPoolInitialize(&in->transitions);
+    in->currentGreen = 0;
+    in->lightState = GREEN_LIGHT;
+    signalControllerInitialize(&in->signal, policy, priority);
+    simRandomSeed(&in->random, seed);
+    memset(&in->stats, 0, sizeof(in->stats));
+    memset(&in->metrics, 0, sizeof(in->metrics));
+    in->lastStuckCleanupMs = 0;
+
+    for (int r = 0; r < 4; r++) in->exits[r].count = 0;
+    in->arrivalCount = 0;
+}
+
+void intersectionRelease(Intersection* in) {
+    for (int r = 0; r < 4; r++) {
+        queueRelease(&in->roads[r].L1);
+        queueRelease(&in->roads[r].L2);
+        queueRelease(&in->roads[r].L3);
+    }
+    for (int r = 0; r < 4; r++) vehicleBufferRelease(&in->exits[r]);
+    free(in->arrivals);
+    in->arrivals = NULL;
+    in->arrivalCount = 0;
+    in->arrivalCapacity = 0;
+}
+
+// Signal first, so every lane update sees this tick's light.
+void intersectionBeginStep(Intersection* in, unsigned long long nowMs) {
+    PROFILE_BEGIN(PROFILE_SIGNALS);
+    signalControllerUpdate(in, nowMs);
+    PROFILE_END(PROFILE_SIGNALS);
+
+    for (int r = 0; r < 4; r++) {
+        RoadData* road = &in->roads[r];
+        in->stats.vehicleUpdates += road->L1.count + road->L2.count + road->L3.count;
+    }
+}
+
+// Lane 3r + k is road r's L(k + 1).
+void intersectionUpdateLane(Intersection* in, int lane) {
+    int r = lane / 3;
+    RoadData* road = &in->roads[r];
+    int hasGreen = r == in->currentGreen && in->lightState == GREEN_LIGHT;
+
+    PROFILE_BEGIN(PROFILE_LANE);
+    switch (lane % 3) {
+    case 0: in->metrics.offscreenDrops[r][0] += updateLaneVehiclesToIntersection(&road->L1, r, hasGreen); break;
+    case 1: in->metrics.offscreenDrops[r][1] += updateLaneVehiclesToIntersection(&road->L2, r, hasGreen); break;
+    default: updateRightTurnLane(&road->L3, r, &in->exits[r]); break;
+    }
+    PROFILE_END(PROFILE_LANE);
+}
+
+void intersectionFinishStep(Intersection* in, unsigned long long nowMs) {
+    in->stats.vehicleUpdates += in->transitions.count;
+    PROFILE_BEGIN(PROFILE_TRANSITIONS);
+    removeStuckTransitionVehicles(in, nowMs);
+    processIntersectionTransitions(in, nowMs);
+    PROFILE_END(PROFILE_TRANSITIONS);
+
+    // handle green light transitions for L1 and L2
+    PROFILE_BEGIN(PROFILE_GREEN_HANDOFF);
+    handOffGreenLightVehicles(in, nowMs);
+    PROFILE_END(PROFILE_GREEN_HANDOFF);
+
+    for (int r = 0; r < 4; r++) {
+        queueCompact(&in->roads[r].L1);
+        queueCompact(&in->roads[r].L2);
+        queueCompact(&in->roads[r].L3);
+    }
+}
+
+void intersectionStep(Intersection* in, unsigned long long nowMs) {
+    intersectionBeginStep(in, nowMs);
+    for (int lane = 0; lane < INTERSECTION_LANES; lane++) intersectionUpdateLane(in, lane);
+    intersectionFinishStep(in, nowMs);
+}
+
+int intersectionVehicleCount(const Intersection* in) {
+    int total = in->transitions.count + in->arrivalCount;
+    for (int r = 0; r < 4; r++) {
+        total += in->roads[r].L1.count + in->roads[r].L2.count + in->roads[r].L3.count;
+    }
+    return total;
+}
+
+void intersectionSaveSnapshot(const Intersection* in, SnapshotBuffer* out) {
+    for (int r = 0; r < 4; r++) {
+        queueSaveSnapshot(&in->roads[r].L1, out);
+        queueSaveSnapshot(&in->roads[r].L2, out);
+        queueSaveSnapshot(&in->roads[r].L3, out);
+    }
+    snapshotPut(out, &in->transitions, sizeof(in->transitions));
+    snapshotPut(out, &in->currentGreen, sizeof(in->currentGreen));
+    snapshotPut(out, &in->lightState, sizeof(in->lightState));
+    snapshotPut(out, &in->signal, sizeof(in->signal));
+    snapshotPut(out, &in->random, sizeof(in->random));
+    snapshotPut(out, &in->stats, sizeof(in->stats));
+    snapshotPut(out, &in->lastStuckCleanupMs, sizeof(in->lastStuckCleanupMs));
+    snapshotPut(out, &in->arrivalCount, sizeof(in->arrivalCount));
+    snapshotPut(out, in->arrivals, sizeof(VehicleArrival) * in->arrivalCount);
+}
+
+// The policy and priority settings of the current run are kept, so a saved
+// jam can be replayed under another controller. Metrics start from zero.
+int intersectionLoadSnapshot(Intersection* in, SnapshotReader* r) {
+    for (int road = 0; road < 4; road++) {
+        if (!queueLoadSnapshot(&in->roads[road].L1, r)
+            || !queueLoadSnapshot(&in->roads[road].L2, r)
+            || !queueLoadSnapshot(&in->roads[road].L3, r)) return 0;
+    }
+
+    SignalPolicy policy = in->signal.policy;
+    SignalPriority priority = in->signal.priority;
+    int arrivalCount;
+    int ok = snapshotGet(r, &in->transitions, sizeof(in->transitions))
+        && snapshotGet(r, &in->currentGreen, sizeof(in->currentGreen))
+        && snapshotGet(r, &in->lightState, sizeof(in->lightState))
+        && snapshotGet(r, &in->signal, sizeof(in->signal))
+        && snapshotGet(r, &in->random, sizeof(in->random))
+        && snapshotGet(r, &in->stats, sizeof(in->stats))
+        && snapshotGet(r, &in->lastStuckCleanupMs, sizeof(in->lastStuckCleanupMs))
+        && snapshotGet(r, &arrivalCount, sizeof(arrivalCount));
+    in->signal.policy = policy;
+    in->signal.priority = priority;
+    if (!priority.enabled) in->signal.priorityActive = 0;
+    memset(&in->metrics, 0, sizeof(in->metrics));
+    for (int e = 0; e < 4; e++) in->exits[e].count = 0;
+    in->arrivalCount = 0;
+    if (!ok || arrivalCount < 0) return 0;
+
+    if (arrivalCount > in->arrivalCapacity) {
+        VehicleArrival* arrivals = realloc(in->arrivals, sizeof(VehicleArrival) * arrivalCount);
+        if (!arrivals) return 0;
+        in->arrivals = arrivals;
+        in->arrivalCapacity = arrivalCount;
+    }
+    if (arrivalCount > 0 && !snapshotGet(r, in->arrivals, sizeof(VehicleArrival) * arrivalCount)) return 0;
+    in->arrivalCount = arrivalCount;
+    return 1;
+}
+
+int intersectionIsIdle(const Intersection* in) {
+    return intersectionVehicleCount(in) == 0 && signalControllerCanSkipIdle(&in->signal);
+}
+
+// Ticks in [fromMs, toMs), all on the tick grid. Empty lanes and an empty
+// transition pool leave nothing behind but the signal bookkeeping and the
+// stuck-vehicle sweep stamp; light switches are the caller's events.
+void intersectionSkipIdleTicks(Intersection* in, unsigned long long fromMs, unsigned long long toMs) {
+    if (toMs <= fromMs) return;
+    signalControllerSkipIdleTicks(&in->signal, fromMs, toMs);
+
+    unsigned long long sweepEvery = (STUCK_CLEANUP_INTERVAL_MS + SIM_TICK_MS - 1) / SIM_TICK_MS * SIM_TICK_MS;
+    unsigned long long lastTick = toMs - SIM_TICK_MS;
+    unsigned long long nextSweep = in->lastStuckCleanupMs + sweepEvery;
+    if (nextSweep < fromMs) nextSweep = fromMs;
+    if (nextSweep <= lastTick) {
+        in->lastStuckCleanupMs = nextSweep + (lastTick - nextSweep) / sweepEvery * sweepEvery;
+    }
+}
+
+static int pushArrival(Intersection* in, const VehicleArrival* a) {
+    if (in->arrivalCount == in->arrivalCapacity) {
+        int capacity = in->arrivalCapacity ? in->arrivalCapacity * 2 : LANE_INITIAL_CAPACITY;
+        VehicleArrival* arrivals = realloc(in->arrivals, sizeof(VehicleArrival) * capacity);
+        if (!arrivals) return 0;
+        in->arrivals = arrivals;
+        in->arrivalCapacity = capacity;
+    }
+    in->arrivals[in->arrivalCount++] = *a;
+    return 1;
+}
+
+// Places waiting arrivals in order. Once one is blocked, later arrivals for
+// the same road and lane wait behind it so nobody overtakes at the border.
+static void placeArrivals(Intersection* in) {
+    unsigned char blocked[4][4] = { { 0 } };
+    int kept = 0;
+
+    for (int i = 0; i < in->arrivalCount; i++) {
+        VehicleArrival* a = &in->arrivals[i];
+        int lane = a->rec.lane & 3;
+        if (!blocked[a->road][lane] && spawnVehicleFromRecord(in, a->road, &a->rec, a->spawnMs)) {
+            in->stats.handOffsIn++;
+            continue;
+        }
+        blocked[a->road][lane] = 1;
+        in->arrivals[kept++] = *a;
+    }
+    in->arrivalCount = kept;
+}
+
+static void handOffExits(Intersection* in, VehicleBuffer* exits, unsigned long long nowMs) {
+    for (int k = 0; k < exits->count; k++) {
+        const Vehicle* v = &exits->items[k];
+        Intersection* next = in->neighbours[v->fromRoad];
+        metricsRecordLeftLane(&in->metrics, v->fromRoad, v, nowMs);
+        if (!next) {
+            in->stats.vehiclesExited++;
+            metricsRecordExit(&in->metrics, v, nowMs);
+            continue;
+        }
+
+        // Arrivals join the turning (L1) or straight (L2) lane;
+        // L3 only carries traffic away from a junction.
+        VehicleArrival a;
+        a.road = (v->fromRoad + 2) % 4;
+        a.rec.id = v->id;
+        a.rec.lane = simRandomRange(&next->random, 0, 2) == 0 ? 1 : 2;
+        memcpy(a.rec.name, v->name, NAME_MAX);
+        a.spawnMs = v->times.spawnMs;
+        if (!pushArrival(next, &a)) {
+            metricsRecordDrop(&in->metrics, METRICS_DROP_HANDOFF);
+        }
+    }
+    exits->count = 0;
+}
+
+// Runs on one thread between parallel steps. Intersections are visited in
+// index order and each one's exit buffers in road order, so the result does
+// not depend on how the work was spread over threads.
+void intersectionGridHandOff(IntersectionGrid* g, unsigned long long nowMs) {
+    for (int i = 0; i < g->count; i++) {
+        for (int r = 0; r < 4; r++) handOffExits(&g->cells[i], &g->cells[i].exits[r], nowMs);
+    }
+
+    for (int i = 0; i < g->count; i++) {
+        if (g->cells[i].arrivalCount > 0) placeArrivals(&g->cells[i]);
+    }
+}
+
+int intersectionGridCreate(IntersectionGrid* g, int rows, int cols) {
+    if (rows < 1) rows = 1;
+    if (cols < 1) cols = 1;
+
+    g->cells = calloc((size_t)rows * cols, sizeof(Intersection));
+    if (!g->cells) return 0;
+    g->rows = rows;
+    g->cols = cols;
+    g->count = rows * cols;
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            Intersection* in = &g->cells[row * cols + col];
+            in->index = row * cols + col;
+            in->row = row;
+            in->col = col;
+            in->neighbours[0] = row > 0 ? in - cols : NULL;
+            in->neighbours[1] = col + 1 < cols ? in + 1 : NULL;
+            in->neighbours[2] = row + 1 < rows ? in + cols : NULL;
+            in->neighbours[3] = col > 0 ? in - 1 : NULL;
+        }
+    }
+    return 1;
+}
+
+void intersectionGridRelease(IntersectionGrid* g) {
+    for (int i = 0; i < g->count; i++) intersectionRelease(&g->cells[i]);
+    free(g->cells);
+    g->cells = NULL;
+    g->rows = 0;
+    g->cols = 0;
+    g->count = 0;
+}
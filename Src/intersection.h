@@ -0,0 +1,79 @@
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include "types.h"
+#include "random.h"
+#include "signalcontrol.h"
+#include "metrics.h"
+#include "snapshot.h"
+
+// Three lanes on each of the four roads; lane task 3r + k is road r's
+// L(k + 1), see intersectionUpdateLane().
+#define INTERSECTION_LANES 12
+
+// A vehicle handed over by a neighbour, waiting for its spawn point to clear.
+typedef struct {
+    int road;   // inbound road at the receiving intersection
+    VehicleRecord rec;
+    unsigned int spawnMs;   // when the vehicle entered the network
+} VehicleArrival;
+
+typedef struct {
+    unsigned long long vehicleUpdates;
+    unsigned long long vehiclesEntered;
+    unsigned long long vehiclesExited;   // left the network here
+    unsigned long long handOffsIn;       // placed after crossing from a neighbour
+} IntersectionStats;
+
+// One junction with its own approaches, transition area and signal, all in
+// a local SCREEN_W x SCREEN_H frame. intersectionStep() touches nothing
+// outside the struct, so separate intersections can step on separate
+// threads; vehicles only cross between them in intersectionGridHandOff().
+//
+// A step can also be split into begin, one update per lane and finish. The
+// INTERSECTION_LANES lane updates of one intersection may then run
+// concurrently: each touches only its own Lane and exit buffer.
+struct Intersection {
+    RoadData roads[4];
+    TransitionPool transitions;
+    int currentGreen;
+    int lightState;
+    SignalState signal;
+    SimRandom random;
+    IntersectionStats stats;
+    IntersectionMetrics metrics;
+    unsigned long long lastStuckCleanupMs;
+
+    int index, row, col;
+    Intersection* neighbours[4];   // reached by leaving through road r; NULL at the grid edge
+    VehicleBuffer exits[4];        // left through road r's L3 lane this tick
+    VehicleArrival* arrivals;
+    int arrivalCount, arrivalCapacity;
+};
+
+// Row-major N x M grid. Road 0 leaves to the north (row - 1), road 1 to the
+// east, road 2 to the south and road 3 to the west; a vehicle leaving
+// through road r arrives on road (r + 2) % 4 of the neighbour.
+typedef struct {
+    Intersection* cells;
+    int rows, cols, count;
+} IntersectionGrid;
+
+int intersectionGridCreate(IntersectionGrid* g, int rows, int cols);
+void intersectionGridRelease(IntersectionGrid* g);
+void intersectionInitialize(Intersection* in, unsigned long long seed, SignalPolicy policy, const SignalPriority* priority);
+void intersectionRelease(Intersection* in);
+void intersectionStep(Intersection* in, unsigned long long nowMs);
+void intersectionBeginStep(Intersection* in, unsigned long long nowMs);
+void intersectionUpdateLane(Intersection* in, int lane);
+void intersectionFinishStep(Intersection* in, unsigned long long nowMs);
+void intersectionGridHandOff(IntersectionGrid* g, unsigned long long nowMs);
+int intersectionVehicleCount(const Intersection* in);
+// No vehicles anywhere in it and a signal whose idle updates are known in
+// advance, so the event-driven engine may skip its ticks.
+int intersectionIsIdle(const Intersection* in);
+void intersectionSkipIdleTicks(Intersection* in, unsigned long long fromMs, unsigned long long toMs);
+void intersectionSaveSnapshot(const Intersection* in, SnapshotBuffer* out);
+int intersectionLoadSnapshot(Intersection* in, SnapshotReader* r);
+
+#endif // INTERSECTION_H
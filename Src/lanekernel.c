@@ -0,0 +1,92 @@
+#include "lanekernel.h"
+#include "config.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LANE_KERNEL_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LANE_KERNEL_WIDTH 4
+#else
+#define LANE_KERNEL_WIDTH 1
+#endif
+
+static void advanceScalar(const float* p, int begin, int n, const LaneKernelParams* k,
+    float* pNew, int* redStop, int* aheadBlocked) {
+    for (int i = begin; i < n; i++) {
+        float moved = p[i] + k->speed;
+        float toStop = k->stopLine - p[i];
+        pNew[i] = moved;
+        redStop[i] = (!k->hasGreen && toStop < STOPPING_DISTANCE && toStop > 0) ? -1 : 0;
+        aheadBlocked[i] = ((i > 0 || k->hasAhead) && fabsf(moved - p[i - 1]) < MIN_SPACING) ? -1 : 0;
+    }
+}
+
+void laneKernelAdvance(const float* p, int n, const LaneKernelParams* k,
+    float* pNew, int* redStop, int* aheadBlocked) {
+    // The first vehicle reads p[-1] only when hasAhead says it exists.
+    int i = 0;
+    if (n > 0 && !k->hasAhead) {
+        advanceScalar(p, 0, 1, k, pNew, redStop, aheadBlocked);
+        i = 1;
+    }
+
+#if LANE_KERNEL_WIDTH == 8
+    const __m256 speed = _mm256_set1_ps(k->speed);
+    const __m256 stopLine = _mm256_set1_ps(k->stopLine);
+    const __m256 stopping = _mm256_set1_ps(STOPPING_DISTANCE);
+    const __m256 spacing = _mm256_set1_ps(MIN_SPACING);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 redMask = _mm256_castsi256_ps(_mm256_set1_epi32(k->hasGreen ? 0 : -1));
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 pos = _mm256_loadu_ps(p + i);
+        __m256 ahead = _mm256_loadu_ps(p + i - 1);
+        __m256 moved = _mm256_add_ps(pos, speed);
+        __m256 toStop = _mm256_sub_ps(stopLine, pos);
+        __m256 red = _mm256_and_ps(redMask, _mm256_and_ps(
+            _mm256_cmp_ps(toStop, stopping, _CMP_LT_OQ), _mm256_cmp_ps(toStop, zero, _CMP_GT_OQ)));
+        __m256 gap = _mm256_and_ps(_mm256_sub_ps(moved, ahead), absMask);
+        __m256 blocked = _mm256_cmp_ps(gap, spacing, _CMP_LT_OQ);
+
+        _mm256_storeu_ps(pNew + i, moved);
+        _mm256_storeu_si256((__m256i*)(redStop + i), _mm256_castps_si256(red));
+        _mm256_storeu_si256((__m256i*)(aheadBlocked + i), _mm256_castps_si256(blocked));
+    }
+#elif LANE_KERNEL_WIDTH == 4
+    const __m128 speed = _mm_set1_ps(k->speed);
+    const __m128 stopLine = _mm_set1_ps(k->stopLine);
+    const __m128 stopping = _mm_set1_ps(STOPPING_DISTANCE);
+    const __m128 spacing = _mm_set1_ps(MIN_SPACING);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 redMask = _mm_castsi128_ps(_mm_set1_epi32(k->hasGreen ? 0 : -1));
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 pos = _mm_loadu_ps(p + i);
+        __m128 ahead = _mm_loadu_ps(p + i - 1);
+        __m128 moved = _mm_add_ps(pos, speed);
+        __m128 toStop = _mm_sub_ps(stopLine, pos);
+        __m128 red = _mm_and_ps(redMask, _mm_and_ps(_mm_cmplt_ps(toStop, stopping), _mm_cmpgt_ps(toStop, zero)));
+        __m128 gap = _mm_and_ps(_mm_sub_ps(moved, ahead), absMask);
+        __m128 blocked = _mm_cmplt_ps(gap, spacing);
+
+        _mm_storeu_ps(pNew + i, moved);
+        _mm_storeu_si128((__m128i*)(redStop + i), _mm_castps_si128(red));
+        _mm_storeu_si128((__m128i*)(aheadBlocked + i), _mm_castps_si128(blocked));
+    }
+#endif
+
+    advanceScalar(p, i, n, k, pNew, redStop, aheadBlocked);
+}
+
+const char* laneKernelName(void) {
+#if LANE_KERNEL_WIDTH == 8
+    return "avx";
+#elif LANE_KERNEL_WIDTH == 4
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
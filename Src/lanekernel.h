@@ -0,0 +1,24 @@
+#ifndef LANEKERNEL_H
+#define LANEKERNEL_H
+
+// Data-parallel half of an inbound lane update. Positions are projected onto
+// the road's axis (progress toward the stop line), so every vehicle is one
+// float and a whole lane is handled without per-road branches. Built with
+// AVX (8 vehicles per step) or SSE2 (4) when the compiler targets them,
+// otherwise scalar.
+typedef struct {
+    float speed;      // progress per tick
+    float stopLine;   // progress at which the stop zone ends
+    int hasGreen;
+    int hasAhead;     // p[-1] is valid: the vehicle ahead of the first one
+} LaneKernelParams;
+
+// For n vehicles with progress p[0..n) (front first), writes the moved
+// progress, whether the vehicle must hold for a red light, and whether the
+// moved position comes within MIN_SPACING of the vehicle ahead's current
+// position. Masks are 0 or -1.
+void laneKernelAdvance(const float* p, int n, const LaneKernelParams* k,
+    float* pNew, int* redStop, int* aheadBlocked);
+const char* laneKernelName(void);
+
+#endif // LANEKERNEL_H
@@ -0,0 +1,306 @@
+#include "metrics.h"
+#include "globals.h"
+#include "fileio.h"
+
+// Network-wide queue lengths at one instant.
+typedef struct {
+    unsigned long long timeMs;
+    int lanes[4][3];
+    int transitions;
+} QueueSample;
+
+static IntersectionMetrics window;       // merged at each export
+static IntersectionMetrics cumulative;   // the whole run
+static int peakQueue[4][3];
+static QueueSample* samples = NULL;
+static int sampleCount = 0;
+static int sampleCapacity = 0;
+static FILE* exportFile = NULL;
+static unsigned long long intervalMs = (unsigned long long)(METRICS_DEFAULT_INTERVAL_S * 1000.0);
+static unsigned long long lastSampleMs = 0;
+static unsigned long long windowStartMs = 0;
+static int runIndex = 0;
+
+static const char roadNames[] = "ABCD";
+
+void metricsRecordSpawn(IntersectionMetrics* m, unsigned int waitedMs) {
+    m->spawned++;
+    histogramRecord(&m->entryDelay, waitedMs);
+}
+
+void metricsRecordDeferred(IntersectionMetrics* m) {
+    m->deferred++;
+}
+
+// lane is 1 or 2; L3 traffic never enters the intersection.
+void metricsRecordEntry(IntersectionMetrics* m, int road, int lane, Vehicle* v, unsigned long long nowMs) {
+    unsigned int now = (unsigned int)nowMs;
+    histogramRecord(&m->laneDelay[road][lane - 1], now - v->times.laneMs);
+    if (v->times.firstStopMs != VEHICLE_TIME_UNSET) {
+        histogramRecord(&m->stopDelay[road][lane - 1], now - v->times.firstStopMs);
+    }
+    v->times.entryMs = now;
+    m->phaseServed++;
+}
+
+// The vehicle now starts on its outbound L3.
+void metricsRecordCrossed(IntersectionMetrics* m, Vehicle* v, unsigned long long nowMs) {
+    unsigned int now = (unsigned int)nowMs;
+    if (v->times.entryMs != VEHICLE_TIME_UNSET) histogramRecord(&m->crossing, now - v->times.entryMs);
+    v->times.laneMs = now;
+    v->times.firstStopMs = VEHICLE_TIME_UNSET;
+    v->times.entryMs = VEHICLE_TIME_UNSET;
+}
+
+void metricsRecordLeftLane(IntersectionMetrics* m, int road, const Vehicle* v, unsigned long long nowMs) {
+    histogramRecord(&m->laneDelay[road][2], (unsigned int)nowMs - v->times.laneMs);
+}
+
+void metricsRecordExit(IntersectionMetrics* m, const Vehicle* v, unsigned long long nowMs) {
+    m->exited++;
+    histogramRecord(&m->journey, (unsigned int)nowMs - v->times.spawnMs);
+}
+
+void metricsRecordDrop(IntersectionMetrics* m, MetricsDrop reason) {
+    m->drops[reason]++;
+}
+
+void metricsRecordPhase(IntersectionMetrics* m, int road, unsigned long long greenMs) {
+    m->phases[road].phases++;
+    m->phases[road].served += m->phaseServed;
+    m->phases[road].greenMs += greenMs;
+    m->phaseServed = 0;
+}
+
+static void mergeMetrics(IntersectionMetrics* into, const IntersectionMetrics* from) {
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 3; k++) {
+            histogramMerge(&into->laneDelay[r][k], &from->laneDelay[r][k]);
+            if (k < 2) histogramMerge(&into->stopDelay[r][k], &from->stopDelay[r][k]);
+            into->offscreenDrops[r][k] += from->offscreenDrops[r][k];
+        }
+        into->phases[r].phases += from->phases[r].phases;
+        into->phases[r].served += from->phases[r].served;
+        into->phases[r].greenMs += from->phases[r].greenMs;
+    }
+    histogramMerge(&into->crossing, &from->crossing);
+    histogramMerge(&into->journey, &from->journey);
+    histogramMerge(&into->entryDelay, &from->entryDelay);
+    for (int d = 0; d < METRICS_DROP_COUNT; d++) into->drops[d] += from->drops[d];
+    into->spawned += from->spawned;
+    into->deferred += from->deferred;
+    into->exited += from->exited;
+}
+
+static unsigned long long countOffscreenDrops(const IntersectionMetrics* m) {
+    unsigned long long total = 0;
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 3; k++) total += m->offscreenDrops[r][k];
+    }
+    return total;
+}
+
+// Moves everything recorded since the last window out of the intersections.
+// The count for a green that is still running stays where it is.
+static void collectWindow(void) {
+    memset(&window, 0, sizeof(window));
+    for (int i = 0; i < network.count; i++) {
+        IntersectionMetrics* m = &network.cells[i].metrics;
+        unsigned long long served = m->phaseServed;
+        mergeMetrics(&window, m);
+        memset(m, 0, sizeof(*m));
+        m->phaseServed = served;
+    }
+    mergeMetrics(&cumulative, &window);
+}
+
+static void sampleQueues(unsigned long long nowMs) {
+    QueueSample s;
+    memset(&s, 0, sizeof(s));
+    s.timeMs = nowMs;
+    for (int i = 0; i < network.count; i++) {
+        const Intersection* in = &network.cells[i];
+        for (int r = 0; r < 4; r++) {
+            s.lanes[r][0] += in->roads[r].L1.count;
+            s.lanes[r][1] += in->roads[r].L2.count;
+            s.lanes[r][2] += in->roads[r].L3.count;
+        }
+        s.transitions += in->transitions.count;
+    }
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 3; k++) {
+            if (s.lanes[r][k] > peakQueue[r][k]) peakQueue[r][k] = s.lanes[r][k];
+        }
+    }
+
+    // Only kept for the export; the summary just needs the peaks.
+    if (!exportFile) return;
+    if (sampleCount == sampleCapacity) {
+        int capacity = sampleCapacity ? sampleCapacity * 2 : 64;
+        QueueSample* grown = realloc(samples, sizeof(QueueSample) * capacity);
+        if (!grown) return;
+        samples = grown;
+        sampleCapacity = capacity;
+    }
+    samples[sampleCount++] = s;
+}
+
+static void writeHistogram(FILE* f, const Histogram* h) {
+    fprintf(f, "{\"count\":%llu,\"mean\":%.1f,\"p50\":%.0f,\"p90\":%.0f,\"p99\":%.0f,\"max\":%llu}",
+        h->count, histogramMean(h), histogramPercentile(h, 0.50), histogramPercentile(h, 0.90),
+        histogramPercentile(h, 0.99), h->max);
+}
+
+// One JSON object per line and window; see README for the fields.
+static void writeWindow(unsigned long long nowMs) {
+    FILE* f = exportFile;
+    if (!f) return;
+
+    fprintf(f, "{\"run\":%d,\"time_s\":%.3f,\"window_s\":%.3f,\"spawned\":%llu,\"deferred\":%llu,\"exited\":%llu",
+        runIndex, nowMs / 1000.0, (nowMs - windowStartMs) / 1000.0, window.spawned, window.deferred, window.exited);
+    fprintf(f, ",\"dropped\":{\"offscreen\":%llu,\"stuck\":%llu,\"handoff\":%llu,\"invalid\":%llu}",
+        countOffscreenDrops(&window), window.drops[METRICS_DROP_STUCK], window.drops[METRICS_DROP_HANDOFF],
+        window.drops[METRICS_DROP_INVALID]);
+
+    fprintf(f, ",\"journey_ms\":");
+    writeHistogram(f, &window.journey);
+    fprintf(f, ",\"crossing_ms\":");
+    writeHistogram(f, &window.crossing);
+    fprintf(f, ",\"entry_delay_ms\":");
+    writeHistogram(f, &window.entryDelay);
+
+    fprintf(f, ",\"lane_delay_ms\":{");
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 3; k++) {
+            fprintf(f, "%s\"%c%d\":", r + k ? "," : "", roadNames[r], k + 1);
+            writeHistogram(f, &window.laneDelay[r][k]);
+        }
+    }
+    fprintf(f, "},\"stop_delay_ms\":{");
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 2; k++) {
+            fprintf(f, "%s\"%c%d\":", r + k ? "," : "", roadNames[r], k + 1);
+            writeHistogram(f, &window.stopDelay[r][k]);
+        }
+    }
+
+    fprintf(f, "},\"phases\":{");
+    for (int r = 0; r < 4; r++) {
+        const PhaseThroughput* p = &window.phases[r];
+        double greenMinutes = p->greenMs / 60000.0;
+        fprintf(f, "%s\"%c\":{\"phases\":%llu,\"served\":%llu,\"green_s\":%.1f,\"per_green_min\":%.2f}",
+            r ? "," : "", roadNames[r], p->phases, p->served, p->greenMs / 1000.0,
+            greenMinutes > 0.0 ? p->served / greenMinutes : 0.0);
+    }
+
+    fprintf(f, "},\"queue\":{\"sample_ms\":%d,\"samples\":[", METRICS_SAMPLE_MS);
+    for (int i = 0; i < sampleCount; i++) {
+        const QueueSample* s = &samples[i];
+        fprintf(f, "%s[%.3f", i ? "," : "", s->timeMs / 1000.0);
+        for (int r = 0; r < 4; r++) {
+            for (int k = 0; k < 3; k++) fprintf(f, ",%d", s->lanes[r][k]);
+        }
+        fprintf(f, ",%d]", s->transitions);
+    }
+    fprintf(f, "]}}\n");
+    fflush(f);
+    sampleCount = 0;
+}
+
+int metricsStart(const char* path, double intervalSeconds) {
+    if (intervalSeconds > 0.0) intervalMs = (unsigned long long)(intervalSeconds * 1000.0);
+    if (!path) return 1;
+    exportFile = fopen(path, "w");
+    return exportFile != NULL;
+}
+
+void metricsStop(void) {
+    if (exportFile) fclose(exportFile);
+    exportFile = NULL;
+    free(samples);
+    samples = NULL;
+    sampleCount = 0;
+    sampleCapacity = 0;
+}
+
+void metricsReset(void) {
+    memset(&window, 0, sizeof(window));
+    memset(&cumulative, 0, sizeof(cumulative));
+    memset(peakQueue, 0, sizeof(peakQueue));
+    sampleCount = 0;
+    lastSampleMs = 0;
+    windowStartMs = 0;
+    runIndex++;
+}
+
+// After a snapshot restore: the first window and sample start at nowMs.
+void metricsRestartAt(unsigned long long nowMs) {
+    metricsReset();
+    lastSampleMs = nowMs;
+    windowStartMs = nowMs;
+}
+
+// Runs on the main thread between ticks, when no intersection is stepping.
+void metricsTick(unsigned long long nowMs) {
+    if (nowMs - lastSampleMs >= METRICS_SAMPLE_MS) {
+        sampleQueues(nowMs);
+        lastSampleMs = nowMs;
+    }
+    if (exportFile && nowMs - windowStartMs >= intervalMs) {
+        collectWindow();
+        writeWindow(nowMs);
+        windowStartMs = nowMs;
+    }
+}
+
+unsigned long long metricsNextDueMs(void) {
+    unsigned long long due = lastSampleMs + METRICS_SAMPLE_MS;
+    if (exportFile && windowStartMs + intervalMs < due) due = windowStartMs + intervalMs;
+    return due;
+}
+
+void metricsFinish(unsigned long long nowMs) {
+    collectWindow();
+    writeWindow(nowMs);
+    windowStartMs = nowMs;
+}
+
+void metricsPrintSummary(void) {
+    const IntersectionMetrics* m = &cumulative;
+    printf("=== Vehicle Metrics (simulated ms) ===\n");
+    printf("Entered the network: %llu (%llu waited for the spawn point, %d still waiting), left: %llu\n",
+        m->spawned, m->deferred, countPendingSpawns(), m->exited);
+    printf("Dropped: %llu off screen, %llu stuck in the intersection, %llu at a full neighbour, %llu invalid input\n",
+        countOffscreenDrops(m), m->drops[METRICS_DROP_STUCK], m->drops[METRICS_DROP_HANDOFF],
+        m->drops[METRICS_DROP_INVALID]);
+    printf("Journey:  p50 %.0f  p99 %.0f  max %llu\n",
+        histogramPercentile(&m->journey, 0.50), histogramPercentile(&m->journey, 0.99), m->journey.max);
+    printf("Crossing: p50 %.0f  p99 %.0f  max %llu\n",
+        histogramPercentile(&m->crossing, 0.50), histogramPercentile(&m->crossing, 0.99), m->crossing.max);
+    printf("Entry:    p50 %.0f  p99 %.0f  max %llu\n",
+        histogramPercentile(&m->entryDelay, 0.50), histogramPercentile(&m->entryDelay, 0.99), m->entryDelay.max);
+
+    printf("lane  %8s %8s %8s %8s  %8s %8s %8s  %6s\n", "vehicles", "p50", "p99", "max", "stopped", "stop p50", "stop p99", "peak q");
+    for (int r = 0; r < 4; r++) {
+        for (int k = 0; k < 3; k++) {
+            const Histogram* d = &m->laneDelay[r][k];
+            printf("%c%d    %8llu %8.0f %8.0f %8llu", roadNames[r], k + 1, d->count,
+                histogramPercentile(d, 0.50), histogramPercentile(d, 0.99), d->max);
+            if (k < 2) {
+                const Histogram* s = &m->stopDelay[r][k];
+                printf("  %8llu %8.0f %8.0f", s->count, histogramPercentile(s, 0.50), histogramPercentile(s, 0.99));
+            }
+            else {
+                printf("  %8s %8s %8s", "-", "-", "-");
+            }
+            printf("  %6d\n", peakQueue[r][k]);
+        }
+    }
+
+    for (int r = 0; r < 4; r++) {
+        const PhaseThroughput* p = &m->phases[r];
+        double greenMinutes = p->greenMs / 60000.0;
+        printf("Green %c: %llu phases, %llu served, %.1f per green minute\n", roadNames[r], p->phases, p->served,
+            greenMinutes > 0.0 ? p->served / greenMinutes : 0.0);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "types.h"
+#include "histogram.h"
+
+// Vehicles that leave without exiting normally. Inbound vehicles that drive
+// out of the frame are counted per lane in offscreenDrops instead.
+typedef enum {
+    METRICS_DROP_STUCK,     // cleared from the transition area after waiting too long
+    METRICS_DROP_HANDOFF,   // could not be queued at the neighbouring intersection
+    METRICS_DROP_INVALID,   // input record with no lane 1-3 to enter
+    METRICS_DROP_COUNT
+} MetricsDrop;
+
+typedef struct {
+    unsigned long long phases;
+    unsigned long long served;
+    unsigned long long greenMs;
+} PhaseThroughput;
+
+// Per-intersection aggregators. Only the thread stepping an intersection
+// writes them (in lane mode each lane task only touches its own
+// offscreenDrops entry); metricsTick() merges them on the main thread.
+// Delays are in simulated milliseconds.
+typedef struct {
+    Histogram laneDelay[4][3];   // joined the lane -> entered the intersection (L3: left the frame)
+    Histogram stopDelay[4][2];   // first stop -> entered the intersection, L1 and L2
+    Histogram crossing;          // entered the intersection -> joined the outbound L3
+    Histogram journey;           // entered the network -> left it
+    Histogram entryDelay;        // arrived at the network edge -> placed at the spawn point
+    unsigned long long offscreenDrops[4][3];
+    unsigned long long drops[METRICS_DROP_COUNT];
+    unsigned long long spawned;    // entered the network here
+    unsigned long long deferred;   // arrivals that had to wait for the spawn point
+    unsigned long long exited;     // left the network here
+    PhaseThroughput phases[4];
+    unsigned long long phaseServed;   // entered during the current green
+} IntersectionMetrics;
+
+void metricsRecordSpawn(IntersectionMetrics* m, unsigned int waitedMs);
+void metricsRecordDeferred(IntersectionMetrics* m);
+void metricsRecordEntry(IntersectionMetrics* m, int road, int lane, Vehicle* v, unsigned long long nowMs);
+void metricsRecordCrossed(IntersectionMetrics* m, Vehicle* v, unsigned long long nowMs);
+void metricsRecordLeftLane(IntersectionMetrics* m, int road, const Vehicle* v, unsigned long long nowMs);
+void metricsRecordExit(IntersectionMetrics* m, const Vehicle* v, unsigned long long nowMs);
+void metricsRecordDrop(IntersectionMetrics* m, MetricsDrop reason);
+void metricsRecordPhase(IntersectionMetrics* m, int road, unsigned long long greenMs);
+
+// Run-level pipeline over the global network. metricsStart() opens the
+// JSON Lines export once per process; every run then calls metricsReset(),
+// metricsTick() after each step and metricsFinish() before the grid goes.
+int metricsStart(const char* path, double intervalSeconds);
+void metricsStop(void);
+void metricsReset(void);
+void metricsRestartAt(unsigned long long nowMs);
+void metricsTick(unsigned long long nowMs);
+// Earliest time passed to metricsTick() at which it does anything.
+unsigned long long metricsNextDueMs(void);
+void metricsFinish(unsigned long long nowMs);
+void metricsPrintSummary(void);
+
+#endif // METRICS_H
@@ -1,26 +1,60 @@
 #include "physics.h"
 #include "geometry.h"
-#include "globals.h"
 #include "queue.h"
+#include "lanekernel.h"
 #include <math.h>
 
+#define LANE_KERNEL_CHUNK 256
+
+// Lanes are filled at the back, so progress normally never increases from
+// front to back. When that holds, a vehicle's nearest neighbours in the
+// queue are also its nearest neighbours on the road.
+static int isLaneOrderedAlongRoad(Lane* L, const RoadTraits* t, float direction) {
+    float previous = 0.0f;
+    for (int i = 0; i < L->count; i++) {
+        int s = QUEUE_SLOT(L, i);
+        float progress = direction * measureRoadProgress(t, L->x[s], L->y[s]);
+        if (i > 0 && progress > previous) return 0;
+        previous = progress;
+    }
+    return 1;
+}
+
+static float measureDistanceToFollower(Lane* L, const RoadTraits* t, int vehicleIndex, int follower) {
+    if (follower < 0) return 999999.0f;
+    int current = QUEUE_SLOT(L, vehicleIndex);
+    int next = QUEUE_SLOT(L, follower);
+
+    float distAlongRoad = measureRoadProgress(t, L->x[next], L->y[next])
+        - measureRoadProgress(t, L->x[current], L->y[current]);
+    return distAlongRoad > 0 ? distAlongRoad : 999999.0f;
+}
+
+static int detectCollisionWithQueueNeighbours(Lane* L, float x, float y, int index, int follower) {
+    if (index > 0) {
+        int ahead = QUEUE_SLOT(L, index - 1);
+        if (calculateDistance(x, y, L->x[ahead], L->y[ahead]) < MIN_SPACING) return 1;
+    }
+    if (follower >= 0) {
+        int behind = QUEUE_SLOT(L, follower);
+        if (calculateDistance(x, y, L->x[behind], L->y[behind]) < MIN_SPACING) return 1;
+    }
+    return 0;
+}
+
 float measureDistanceToFrontVehicle(Lane* L, int road, int vehicleIndex) {
-    Vehicle* current = queueGetVehicleAt(L, vehicleIndex);
-    if (!current) return 999999.0f;
+    if (vehicleIndex < 0 || vehicleIndex >= L->count) return 999999.0f;
+    int current = QUEUE_SLOT(L, vehicleIndex);
+    const RoadTraits* t = &roadTraits[road];
+    float progress = measureRoadProgress(t, L->x[current], L->y[current]);
 
     float minDist = 999999.0f;
 
     for (int i = vehicleIndex + 1; i < L->count; i++) {
-        Vehicle* ahead = queueGetVehicleAt(L, i);
-        if (!ahead) continue;
-
-        float distAlongRoad = 0.0f;
-        switch (road) {
-        case 0: distAlongRoad = ahead->y - current->y; break;
-        case 1: distAlongRoad = current->x - ahead->x; break;
-        case 2: distAlongRoad = current->y - ahead->y; break;
-        case 3: distAlongRoad = ahead->x - current->x; break;
-        }
+        int ahead = QUEUE_SLOT(L, i);
+        if (L->isRemoved[ahead]) continue;
+
+        float distAlongRoad = measureRoadProgress(t, L->x[ahead], L->y[ahead]) - progress;
 
         if (distAlongRoad > 0 && distAlongRoad < minDist) {
             minDist = distAlongRoad;
@@ -33,142 +67,229 @@ float measureDistanceToFrontVehicle(Lane* L, int road, int vehicleIndex) {
 int detectCollisionInLane(Lane* l, float x, float y, int skipIndex) {
     for (int i = 0; i < l->count; i++) {
         if (i == skipIndex) continue;
-        Vehicle* other = queueGetVehicleAt(l, i);
-        if (!other) continue;
-        float dist = calculateDistance(x, y, other->x, other->y);
+        int other = QUEUE_SLOT(l, i);
+        if (l->isRemoved[other]) continue;
+        float dist = calculateDistance(x, y, l->x[other], l->y[other]);
         if (dist < MIN_SPACING) return 1;
     }
     return 0;
 }
 
+// L3 traffic drives away from the intersection, against the inbound direction.
 void calculateRightTurnMovementVector(int road, float* dx, float* dy) {
-    if (road == 0) { *dx = 0.0f; *dy = -VEHICLE_SPEED; }
-    else if (road == 1) { *dx = VEHICLE_SPEED; *dy = 0.0f; }
-    else if (road == 2) { *dx = 0.0f; *dy = VEHICLE_SPEED; }
-    else { *dx = -VEHICLE_SPEED; *dy = 0.0f; }
+    *dx = -roadTraits[road].alongX * VEHICLE_SPEED;
+    *dy = -roadTraits[road].alongY * VEHICLE_SPEED;
 }
 
-void updateRightTurnLane(Lane* L, int road) {
+// Vehicles driving off the edge of the frame go to exits when given.
+void updateRightTurnLane(Lane* L, int road, VehicleBuffer* exits) {
+    const RoadTraits* t = &roadTraits[road];
     float dx, dy;
     calculateRightTurnMovementVector(road, &dx, &dy);
 
+    // In an ordered lane the only vehicle that can block i is the nearest
+    // one strictly ahead of it, which is i - 1 unless the two are level.
+    int ordered = isLaneOrderedAlongRoad(L, t, -1.0f);
+    int leader = -1;
+
     int i = 0;
     while (i < L->count) {
-        Vehicle* v = queueGetVehicleAt(L, i);
-        if (!v) { i++; continue; }
+        int v = QUEUE_SLOT(L, i);
 
-        float newx = v->x + dx;
-        float newy = v->y + dy;
+        float newx = L->x[v] + dx;
+        float newy = L->y[v] + dy;
 
         if (newx < -100 || newx > SCREEN_W + 100 || newy < -100 || newy > SCREEN_H + 100) {
             Vehicle temp;
             queueRemove(L, &temp);
+            temp.fromRoad = road;
+            if (exits) vehicleBufferPush(exits, &temp);
+            leader = -1;
             continue;
         }
 
         int canMove = 1;
-        for (int j = 0; j < L->count; j++) {
-            if (i == j) continue;
-            Vehicle* other = queueGetVehicleAt(L, j);
-            if (!other) continue;
-
-            float distToOther;
-            switch (road) {
-            case 0: distToOther = v->y - other->y; break;
-            case 1: distToOther = other->x - v->x; break;
-            case 2: distToOther = other->y - v->y; break;
-            case 3: distToOther = v->x - other->x; break;
+        float progress = -measureRoadProgress(t, L->x[v], L->y[v]);
+
+        if (ordered) {
+            if (i > 0) {
+                int previous = QUEUE_SLOT(L, i - 1);
+                if (-measureRoadProgress(t, L->x[previous], L->y[previous]) > progress) leader = i - 1;
             }
+            if (leader >= 0) {
+                int ahead = QUEUE_SLOT(L, leader);
+                float distToLeader = -measureRoadProgress(t, L->x[ahead], L->y[ahead]) - progress;
+                if (distToLeader < MIN_SPACING) canMove = 0;
+            }
+        }
+        else {
+            for (int j = 0; j < L->count; j++) {
+                if (i == j) continue;
+                int other = QUEUE_SLOT(L, j);
+
+                float distToOther = -measureRoadProgress(t, L->x[other], L->y[other]) - progress;
 
-            if (distToOther > 0 && distToOther < MIN_SPACING) {
-                canMove = 0;
-                break;
+                if (distToOther > 0 && distToOther < MIN_SPACING) {
+                    canMove = 0;
+                    break;
+                }
             }
         }
 
         if (canMove) {
-            v->x = newx;
-            v->y = newy;
-            v->isStopped = 0;
+            L->x[v] = newx;
+            L->y[v] = newy;
+            L->isStopped[v] = 0;
         }
         else {
-            v->isStopped = 1;
+            L->isStopped[v] = 1;
         }
 
         i++;
     }
 }
 
-void updateLaneVehiclesToIntersection(Lane* L, int road) {
-    float mvx = 0.0f, mvy = 0.0f;
-    if (road == 0) { mvy = VEHICLE_SPEED; }
-    else if (road == 1) { mvx = -VEHICLE_SPEED; }
-    else if (road == 2) { mvy = -VEHICLE_SPEED; }
-    else { mvx = VEHICLE_SPEED; }
+// Ordered inbound lane whose vehicles all sit on one line. Gaps along the
+// axis then equal the distances the general path measures, so the kernel
+// does the arithmetic and this pass only resolves the back-to-front
+// dependency on the follower. Returns 0, having changed nothing, when the
+// lane is not on one line.
+static int updateStraightOrderedLane(Lane* L, const RoadTraits* t, int hasGreen, int* leftFrame) {
+    float* axis = t->alongY != 0.0f ? L->y : L->x;
+    const float* lateral = t->alongY != 0.0f ? L->x : L->y;
+    float sign = t->alongX + t->alongY;
 
-    for (int i = L->count - 1; i >= 0; i--) {
-        Vehicle* v = queueGetVehicleAt(L, i);
-        if (!v) continue;
+    if (L->count == 0) return 1;
+    float line = lateral[QUEUE_SLOT(L, 0)];
+    for (int i = 1; i < L->count; i++) {
+        if (lateral[QUEUE_SLOT(L, i)] != line) return 0;
+    }
+
+    LaneKernelParams k;
+    k.speed = VEHICLE_SPEED;
+    k.stopLine = t->stopLine;
+    k.hasGreen = hasGreen;
+
+    float progress[LANE_KERNEL_CHUNK + 1];
+    float moved[LANE_KERNEL_CHUNK];
+    int redStop[LANE_KERNEL_CHUNK];
+    int aheadBlocked[LANE_KERNEL_CHUNK];
+
+    int follower = -1;
+    float followerProgress = 0.0f;
+
+    // Chunks run back to front like the general path; progress[0] holds the
+    // vehicle just ahead of the chunk, which has not moved yet.
+    for (int end = L->count; end > 0; end -= LANE_KERNEL_CHUNK) {
+        int begin = end > LANE_KERNEL_CHUNK ? end - LANE_KERNEL_CHUNK : 0;
+        k.hasAhead = begin > 0;
+        for (int i = k.hasAhead ? begin - 1 : begin; i < end; i++) {
+            progress[i - begin + 1] = sign * axis[QUEUE_SLOT(L, i)];
+        }
+        laneKernelAdvance(progress + 1, end - begin, &k, moved, redStop, aheadBlocked);
 
-        float cx = SCREEN_W / 2.0f;
-        float cy = SCREEN_H / 2.0f;
-        float distToIntersection;
+        for (int i = end - 1; i >= begin; i--) {
+            if (i + 1 < L->count && !L->isRemoved[QUEUE_SLOT(L, i + 1)]) {
+                follower = i + 1;
+                followerProgress = sign * axis[QUEUE_SLOT(L, follower)];
+            }
+            int v = QUEUE_SLOT(L, i);
+            if (L->isRemoved[v]) continue;
+
+            int j = i - begin;
+            if (redStop[j]) {
+                L->isStopped[v] = 1;
+                continue;
+            }
+
+            if (follower >= 0) {
+                float distToAhead = followerProgress - progress[j + 1];
+                if (distToAhead > 0 && distToAhead < STOPPING_DISTANCE
+                    && (L->isStopped[QUEUE_SLOT(L, follower)] || distToAhead < MIN_FRONT_SPACING)) {
+                    L->isStopped[v] = 1;
+                    continue;
+                }
+            }
+
+            int blocked = aheadBlocked[j] || (follower >= 0 && fabsf(moved[j] - followerProgress) < MIN_SPACING);
+            if (!blocked) {
+                axis[v] = sign * moved[j];
+                L->isStopped[v] = 0;
+            }
+            else {
+                L->isStopped[v] = 1;
+            }
+
+            if (L->x[v] < -100 || L->x[v] > SCREEN_W + 100 || L->y[v] < -100 || L->y[v] > SCREEN_H + 100) {
+                *leftFrame += queueMarkRemoved(L, i, NULL);
+            }
+        }
+    }
+    return 1;
+}
+
+// Returns how many vehicles drove out of the frame and were removed.
+int updateLaneVehiclesToIntersection(Lane* L, int road, int hasGreen) {
+    const RoadTraits* t = &roadTraits[road];
+    float mvx = t->alongX * VEHICLE_SPEED;
+    float mvy = t->alongY * VEHICLE_SPEED;
+
+    // Vehicles only ever compare against their queue neighbours when the
+    // lane is ordered; otherwise fall back to scanning the whole lane.
+    int leftFrame = 0;
+    int ordered = isLaneOrderedAlongRoad(L, t, 1.0f);
+    if (ordered && updateStraightOrderedLane(L, t, hasGreen, &leftFrame)) return leftFrame;
+
+    // Nearest vehicle behind i that is still in the lane this tick.
+    int follower = -1;
+
+    for (int i = L->count - 1; i >= 0; i--) {
+        if (i + 1 < L->count && !L->isRemoved[QUEUE_SLOT(L, i + 1)]) follower = i + 1;
+        int v = QUEUE_SLOT(L, i);
+        if (L->isRemoved[v]) continue;
 
-        if (road == 0) distToIntersection = cy - ROAD_W / 2.0f - v->y;
-        else if (road == 1) distToIntersection = v->x - (cx + ROAD_W / 2.0f);
-        else if (road == 2) distToIntersection = v->y - (cy + ROAD_W / 2.0f);
-        else distToIntersection = cx - ROAD_W / 2.0f - v->x;
+        float distToIntersection = t->stopLine - measureRoadProgress(t, L->x[v], L->y[v]);
 
-        if (lightState == RED_LIGHT || currentGreen != road) {
+        if (!hasGreen) {
             if (distToIntersection < STOPPING_DISTANCE && distToIntersection > 0) {
-                v->isStopped = 1;
+                L->isStopped[v] = 1;
                 continue;
             }
         }
 
-        float distToAhead = measureDistanceToFrontVehicle(L, road, i);
+        float distToAhead = ordered ? measureDistanceToFollower(L, t, i, follower)
+            : measureDistanceToFrontVehicle(L, road, i);
 
         if (distToAhead < STOPPING_DISTANCE) {
-            if (i + 1 < L->count) {
-                Vehicle* ahead = queueGetVehicleAt(L, i + 1);
-                if (ahead && ahead->isStopped) {
-                    v->isStopped = 1;
-                    continue;
-                }
+            if (follower >= 0 && L->isStopped[QUEUE_SLOT(L, follower)]) {
+                L->isStopped[v] = 1;
+                continue;
             }
 
             if (distToAhead < MIN_FRONT_SPACING) {
-                v->isStopped = 1;
+                L->isStopped[v] = 1;
                 continue;
             }
         }
 
-        float newx = v->x + mvx;
-        float newy = v->y + mvy;
+        float newx = L->x[v] + mvx;
+        float newy = L->y[v] + mvy;
+
+        int blocked = ordered ? detectCollisionWithQueueNeighbours(L, newx, newy, i, follower)
+            : detectCollisionInLane(L, newx, newy, i);
 
-        if (!detectCollisionInLane(L, newx, newy, i)) {
-            v->x = newx;
-            v->y = newy;
-            v->isStopped = 0;
+        if (!blocked) {
+            L->x[v] = newx;
+            L->y[v] = newy;
+            L->isStopped[v] = 0;
         }
         else {
-            v->isStopped = 1;
+            L->isStopped[v] = 1;
         }
 
-        if (v->x < -100 || v->x > SCREEN_W + 100 || v->y < -100 || v->y > SCREEN_H + 100) {
-            for (int j = i; j < L->count - 1; j++) {
-                L->data[(L->front + j) % MAX_QUEUE] = L->data[(L->front + j + 1) % MAX_QUEUE];
-            }
-            L->count--;
+        if (L->x[v] < -100 || L->x[v] > SCREEN_W + 100 || L->y[v] < -100 || L->y[v] > SCREEN_H + 100) {
+            leftFrame += queueMarkRemoved(L, i, NULL);
         }
     }
-}
-
-void insertVehicleIntoTransition(Vehicle v, int targetRoad) {
-    if (transitionCount >= MAX_QUEUE) return;
-    v.isStopped = 0;
-    transitions[transitionCount].v = v;
-    transitions[transitionCount].targetRoad = targetRoad;
-    transitions[transitionCount].waitingTime = 0;
-    transitionCount++;
+    return leftFrame;
 }
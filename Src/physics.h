@@ -6,8 +6,7 @@
 float measureDistanceToFrontVehicle(Lane* L, int road, int vehicleIndex);
 int detectCollisionInLane(Lane* l, float x, float y, int skipIndex);
 void calculateRightTurnMovementVector(int road, float* dx, float* dy);
-void updateRightTurnLane(Lane* L, int road);
-void updateLaneVehiclesToIntersection(Lane* L, int road);
-void insertVehicleIntoTransition(Vehicle v, int targetRoad);
+void updateRightTurnLane(Lane* L, int road, VehicleBuffer* exits);
+int updateLaneVehiclesToIntersection(Lane* L, int road, int hasGreen);
 
 #endif // PHYSICS_H
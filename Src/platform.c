@@ -0,0 +1,180 @@
+#include "platform.h"
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+typedef struct {
+    PlatformThreadFunc func;
+    void* arg;
+} ThreadStart;
+
+#ifdef _WIN32
+static DWORD WINAPI threadTrampoline(LPVOID param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+#else
+static void* threadTrampoline(void* param) {
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.func(start.arg);
+    return NULL;
+}
+#endif
+
+int platformThreadCreate(PlatformThread* thread, PlatformThreadFunc func, void* arg) {
+    ThreadStart* start = malloc(sizeof(ThreadStart));
+    if (!start) return 0;
+    start->func = func;
+    start->arg = arg;
+
+#ifdef _WIN32
+    *thread = CreateThread(NULL, 0, threadTrampoline, start, 0, NULL);
+    if (!*thread) {
+        free(start);
+        return 0;
+    }
+#else
+    if (pthread_create(thread, NULL, threadTrampoline, start) != 0) {
+        free(start);
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+void platformThreadJoin(PlatformThread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+int platformCpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+unsigned long long platformNowNs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (unsigned long long)(now.QuadPart / frequency.QuadPart) * 1000000000ULL
+        + (unsigned long long)(now.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+#endif
+}
+
+#ifdef _WIN32
+void platformMutexInit(PlatformMutex* m) { InitializeCriticalSection(m); }
+void platformMutexDestroy(PlatformMutex* m) { DeleteCriticalSection(m); }
+void platformMutexLock(PlatformMutex* m) { EnterCriticalSection(m); }
+void platformMutexUnlock(PlatformMutex* m) { LeaveCriticalSection(m); }
+void platformCondInit(PlatformCond* c) { InitializeConditionVariable(c); }
+void platformCondDestroy(PlatformCond* c) { (void)c; }
+void platformCondWait(PlatformCond* c, PlatformMutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+void platformCondBroadcast(PlatformCond* c) { WakeAllConditionVariable(c); }
+#else
+void platformMutexInit(PlatformMutex* m) { pthread_mutex_init(m, NULL); }
+void platformMutexDestroy(PlatformMutex* m) { pthread_mutex_destroy(m); }
+void platformMutexLock(PlatformMutex* m) { pthread_mutex_lock(m); }
+void platformMutexUnlock(PlatformMutex* m) { pthread_mutex_unlock(m); }
+void platformCondInit(PlatformCond* c) { pthread_cond_init(c, NULL); }
+void platformCondDestroy(PlatformCond* c) { pthread_cond_destroy(c); }
+void platformCondWait(PlatformCond* c, PlatformMutex* m) { pthread_cond_wait(c, m); }
+void platformCondBroadcast(PlatformCond* c) { pthread_cond_broadcast(c); }
+#endif
+
+long long platformFileSize(const char* path) {
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_stat64(path, &st) != 0) return -1;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+#endif
+    return (long long)st.st_size;
+}
+
+int platformMapFile(const char* path, PlatformFileMap* map) {
+    map->data = NULL;
+    map->size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return 0;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return 0;
+
+    // The view keeps the mapping object alive after its handle is closed.
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) return 0;
+
+    map->data = data;
+    map->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+
+    map->data = data;
+    map->size = (size_t)st.st_size;
+#endif
+    return 1;
+}
+
+void platformUnmapFile(PlatformFileMap* map) {
+    if (!map->data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(map->data);
+#else
+    munmap((void*)map->data, map->size);
+#endif
+    map->data = NULL;
+    map->size = 0;
+}
+
+int platformReplaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
@@ -0,0 +1,78 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include "config.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// Thin thread and atomic wrappers so worker code builds with both MSVC and gcc.
+#ifdef _WIN32
+typedef HANDLE PlatformThread;
+typedef CRITICAL_SECTION PlatformMutex;
+typedef CONDITION_VARIABLE PlatformCond;
+typedef volatile LONG PlatformAtomicInt;
+#define PLATFORM_THREAD_LOCAL __declspec(thread)
+
+static inline long platformAtomicLoad(PlatformAtomicInt* p) {
+    return InterlockedCompareExchange(p, 0, 0);
+}
+
+static inline void platformAtomicStore(PlatformAtomicInt* p, long value) {
+    InterlockedExchange(p, value);
+}
+
+static inline long platformAtomicAdd(PlatformAtomicInt* p, long delta) {
+    return InterlockedExchangeAdd(p, delta) + delta;
+}
+#else
+typedef pthread_t PlatformThread;
+typedef pthread_mutex_t PlatformMutex;
+typedef pthread_cond_t PlatformCond;
+typedef volatile long PlatformAtomicInt;
+#define PLATFORM_THREAD_LOCAL __thread
+
+static inline long platformAtomicLoad(PlatformAtomicInt* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void platformAtomicStore(PlatformAtomicInt* p, long value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+static inline long platformAtomicAdd(PlatformAtomicInt* p, long delta) {
+    return __atomic_add_fetch(p, delta, __ATOMIC_ACQ_REL);
+}
+#endif
+
+typedef void (*PlatformThreadFunc)(void* arg);
+
+int platformThreadCreate(PlatformThread* thread, PlatformThreadFunc func, void* arg);
+void platformThreadJoin(PlatformThread thread);
+int platformCpuCount(void);
+unsigned long long platformNowNs(void);   // monotonic
+
+void platformMutexInit(PlatformMutex* m);
+void platformMutexDestroy(PlatformMutex* m);
+void platformMutexLock(PlatformMutex* m);
+void platformMutexUnlock(PlatformMutex* m);
+void platformCondInit(PlatformCond* c);
+void platformCondDestroy(PlatformCond* c);
+void platformCondWait(PlatformCond* c, PlatformMutex* m);
+void platformCondBroadcast(PlatformCond* c);
+
+// Read-only view of a whole file. Mappings are short-lived: on Windows a
+// mapped file cannot be truncated, which would block a writer restarting it.
+typedef struct {
+    const void* data;
+    size_t size;
+} PlatformFileMap;
+
+long long platformFileSize(const char* path);
+int platformMapFile(const char* path, PlatformFileMap* map);
+void platformUnmapFile(PlatformFileMap* map);
+// Renames from over an existing to, so readers see the old or the new file.
+int platformReplaceFile(const char* from, const char* to);
+
+#endif // PLATFORM_H
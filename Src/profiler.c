@@ -0,0 +1,145 @@
+#include "profiler.h"
+#include "histogram.h"
+
+#ifdef SIM_PROFILE
+
+#define PROFILER_MAX_SHARDS 64
+
+// Each recording thread owns a shard, so workers never contend. Shards are
+// merged and cleared on the main thread between ticks, while workers idle.
+typedef struct {
+    Histogram phases[PROFILE_PHASE_COUNT];
+} ProfileShard;
+
+static const char* phaseNames[PROFILE_PHASE_COUNT] = {
+    "tick", "ingest", "signals", "lane", "transitions", "green_handoff", "border_handoff",
+    "frame", "render_scene", "render_vehicles", "render_signals", "present"
+};
+
+static ProfileShard shards[PROFILER_MAX_SHARDS];
+static PlatformAtomicInt shardsInUse = 0;
+static PLATFORM_THREAD_LOCAL int threadShard = -1;
+
+static ProfileSummary latest[PROFILE_PHASE_COUNT];
+static unsigned long long generation = 0;
+static FILE* exportFile = NULL;
+static int exportJson = 0;
+static unsigned long long intervalNs = 5000000000ULL;
+static unsigned long long startNs = 0;
+static unsigned long long windowStartNs = 0;
+
+void profilerRecord(ProfilePhase phase, unsigned long long ns) {
+    if (threadShard < 0) {
+        long claimed = platformAtomicAdd(&shardsInUse, 1) - 1;
+        threadShard = claimed < PROFILER_MAX_SHARDS ? (int)claimed : PROFILER_MAX_SHARDS;
+    }
+    if (threadShard >= PROFILER_MAX_SHARDS) return;
+
+    histogramRecord(&shards[threadShard].phases[phase], ns);
+}
+
+// Merges every shard into latest[] and starts a new window.
+static void rollWindow(void) {
+    int shardCount = (int)platformAtomicLoad(&shardsInUse);
+    if (shardCount > PROFILER_MAX_SHARDS) shardCount = PROFILER_MAX_SHARDS;
+
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        Histogram merged;
+        memset(&merged, 0, sizeof(merged));
+        for (int s = 0; s < shardCount; s++) {
+            histogramMerge(&merged, &shards[s].phases[p]);
+            memset(&shards[s].phases[p], 0, sizeof(Histogram));
+        }
+
+        ProfileSummary* out = &latest[p];
+        out->count = merged.count;
+        out->meanUs = histogramMean(&merged) / 1000.0;
+        out->p50Us = histogramPercentile(&merged, 0.50) / 1000.0;
+        out->p99Us = histogramPercentile(&merged, 0.99) / 1000.0;
+        out->maxUs = merged.max / 1000.0;
+    }
+    generation++;
+}
+
+static void exportWindow(double elapsedSeconds) {
+    if (!exportFile) return;
+
+    if (exportJson) {
+        fprintf(exportFile, "{\"time_s\":%.3f,\"phases\":{", elapsedSeconds);
+        int first = 1;
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+            const ProfileSummary* s = &latest[p];
+            if (s->count == 0) continue;
+            fprintf(exportFile, "%s\"%s\":{\"count\":%llu,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+                first ? "" : ",", phaseNames[p], s->count, s->meanUs, s->p50Us, s->p99Us, s->maxUs);
+            first = 0;
+        }
+        fprintf(exportFile, "}}\n");
+    }
+    else {
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+            const ProfileSummary* s = &latest[p];
+            if (s->count == 0) continue;
+            fprintf(exportFile, "%.3f,%s,%llu,%.3f,%.3f,%.3f,%.3f\n", elapsedSeconds, phaseNames[p],
+                s->count, s->meanUs, s->p50Us, s->p99Us, s->maxUs);
+        }
+    }
+    fflush(exportFile);
+}
+
+// A path ending in .json gets one JSON object per line and per window;
+// anything else gets CSV. A NULL path only keeps the overlay figures.
+int profilerStart(const char* path, double intervalSeconds) {
+    if (intervalSeconds > 0.0) intervalNs = (unsigned long long)(intervalSeconds * 1e9);
+    startNs = platformNowNs();
+    windowStartNs = startNs;
+    memset(latest, 0, sizeof(latest));
+
+    if (!path) return 1;
+    size_t length = strlen(path);
+    exportJson = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+    exportFile = fopen(path, "w");
+    if (!exportFile) return 0;
+    if (!exportJson) fprintf(exportFile, "time_s,phase,count,mean_us,p50_us,p99_us,max_us\n");
+    return 1;
+}
+
+// Call between ticks; rolls the window over once the interval has passed.
+void profilerTick(void) {
+    unsigned long long now = platformNowNs();
+    if (now - windowStartNs < intervalNs) return;
+    rollWindow();
+    exportWindow((now - startNs) / 1e9);
+    windowStartNs = now;
+}
+
+void profilerStop(void) {
+    unsigned long long now = platformNowNs();
+    rollWindow();
+    exportWindow((now - startNs) / 1e9);
+
+    printf("=== Profile (last %.1f s, microseconds) ===\n", (now - windowStartNs) / 1e9);
+    printf("%-16s %10s %9s %9s %9s %9s\n", "phase", "count", "mean", "p50", "p99", "max");
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        const ProfileSummary* s = &latest[p];
+        if (s->count == 0) continue;
+        printf("%-16s %10llu %9.2f %9.2f %9.2f %9.2f\n", phaseNames[p], s->count, s->meanUs, s->p50Us, s->p99Us, s->maxUs);
+    }
+
+    if (exportFile) fclose(exportFile);
+    exportFile = NULL;
+}
+
+const ProfileSummary* profilerLatest(void) {
+    return latest;
+}
+
+unsigned long long profilerGeneration(void) {
+    return generation;
+}
+
+const char* profilePhaseName(ProfilePhase phase) {
+    return phaseNames[phase];
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "platform.h"
+
+// Scoped phase timers, built only with -DSIM_PROFILE. Without it the macros
+// expand to nothing and the calls below are empty inlines, so instrumented
+// code costs nothing in a normal build.
+typedef enum {
+    PROFILE_TICK,
+    PROFILE_INGEST,
+    PROFILE_SIGNALS,
+    PROFILE_LANE,
+    PROFILE_TRANSITIONS,
+    PROFILE_GREEN_HANDOFF,
+    PROFILE_BORDER_HANDOFF,
+    PROFILE_FRAME,
+    PROFILE_RENDER_SCENE,
+    PROFILE_RENDER_VEHICLES,
+    PROFILE_RENDER_SIGNALS,
+    PROFILE_PRESENT,
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+// One export window of a phase; times in microseconds.
+typedef struct {
+    unsigned long long count;
+    double meanUs;
+    double p50Us;
+    double p99Us;
+    double maxUs;
+} ProfileSummary;
+
+#ifdef SIM_PROFILE
+
+#define PROFILE_BEGIN(phase) unsigned long long profileStart_##phase = platformNowNs()
+#define PROFILE_END(phase) profilerRecord(phase, platformNowNs() - profileStart_##phase)
+
+void profilerRecord(ProfilePhase phase, unsigned long long ns);
+int profilerStart(const char* path, double intervalSeconds);
+void profilerTick(void);
+void profilerStop(void);
+const ProfileSummary* profilerLatest(void);
+unsigned long long profilerGeneration(void);
+const char* profilePhaseName(ProfilePhase phase);
+
+#else
+
+#define PROFILE_BEGIN(phase) ((void)0)
+#define PROFILE_END(phase) ((void)0)
+
+static inline int profilerStart(const char* path, double intervalSeconds) {
+    (void)path;
+    (void)intervalSeconds;
+    return 0;
+}
+static inline void profilerTick(void) {}
+static inline void profilerStop(void) {}
+
+#endif
+
+#endif // PROFILER_H
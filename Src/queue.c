@@ -1,29 +1,211 @@
 #include "queue.h"
 
+static void copySlotToVehicle(const Lane* l, int slot, Vehicle* out) {
+    out->id = l->info[slot].id;
+    out->fromRoad = l->info[slot].fromRoad;
+    memcpy(out->name, l->info[slot].name, NAME_MAX);
+    out->times = l->info[slot].times;
+    out->x = l->x[slot];
+    out->y = l->y[slot];
+    out->isStopped = l->isStopped[slot];
+}
+
+// Copies the ring out in logical order so the new arrays start at front = 0.
+static void copyRingInOrder(const Lane* l, void* dst, const void* src, size_t elemSize) {
+    int first = l->capacity - l->front;
+    if (first > l->count) first = l->count;
+    memcpy(dst, (const char*)src + (size_t)l->front * elemSize, (size_t)first * elemSize);
+    memcpy((char*)dst + (size_t)first * elemSize, src, (size_t)(l->count - first) * elemSize);
+}
+
+static int queueGrow(Lane* l) {
+    int capacity = l->capacity ? l->capacity * 2 : LANE_INITIAL_CAPACITY;
+
+    float* x = malloc(sizeof(float) * capacity);
+    float* y = malloc(sizeof(float) * capacity);
+    unsigned char* isStopped = malloc(sizeof(unsigned char) * capacity);
+    unsigned char* isRemoved = malloc(sizeof(unsigned char) * capacity);
+    unsigned int* waitMs = malloc(sizeof(unsigned int) * capacity);
+    VehicleInfo* info = malloc(sizeof(VehicleInfo) * capacity);
+    if (!x || !y || !isStopped || !isRemoved || !waitMs || !info) {
+        free(x); free(y); free(isStopped); free(isRemoved); free(waitMs); free(info);
+        return 0;
+    }
+
+    if (l->count > 0) {
+        copyRingInOrder(l, x, l->x, sizeof(float));
+        copyRingInOrder(l, y, l->y, sizeof(float));
+        copyRingInOrder(l, isStopped, l->isStopped, sizeof(unsigned char));
+        copyRingInOrder(l, isRemoved, l->isRemoved, sizeof(unsigned char));
+        copyRingInOrder(l, waitMs, l->waitMs, sizeof(unsigned int));
+        copyRingInOrder(l, info, l->info, sizeof(VehicleInfo));
+    }
+
+    free(l->x); free(l->y); free(l->isStopped); free(l->isRemoved); free(l->waitMs); free(l->info);
+    l->x = x;
+    l->y = y;
+    l->isStopped = isStopped;
+    l->isRemoved = isRemoved;
+    l->waitMs = waitMs;
+    l->info = info;
+    l->front = 0;
+    l->capacity = capacity;
+    l->mask = capacity - 1;
+    return 1;
+}
+
 void queueInitialize(Lane* l) {
+    l->x = NULL;
+    l->y = NULL;
+    l->isStopped = NULL;
+    l->isRemoved = NULL;
+    l->waitMs = NULL;
+    l->info = NULL;
     l->front = 0;
-    l->rear = -1;
     l->count = 0;
+    l->capacity = 0;
+    l->mask = 0;
+    l->removedCount = 0;
+}
+
+void queueRelease(Lane* l) {
+    free(l->x);
+    free(l->y);
+    free(l->isStopped);
+    free(l->isRemoved);
+    free(l->waitMs);
+    free(l->info);
+    queueInitialize(l);
 }
 
 int queueInsert(Lane* l, Vehicle v) {
-    if (l->count >= MAX_QUEUE) return 0;
-    l->rear = (l->rear + 1) % MAX_QUEUE;
-    l->data[l->rear] = v;
+    if (l->count >= l->capacity && !queueGrow(l)) return 0;
+    int slot = QUEUE_SLOT(l, l->count);
+    l->x[slot] = v.x;
+    l->y[slot] = v.y;
+    l->isStopped[slot] = (unsigned char)(v.isStopped != 0);
+    l->isRemoved[slot] = 0;
+    l->waitMs[slot] = 0;
+    l->info[slot].id = v.id;
+    l->info[slot].fromRoad = v.fromRoad;
+    memcpy(l->info[slot].name, v.name, NAME_MAX);
+    l->info[slot].times = v.times;
     l->count++;
     return 1;
 }
 
+static void popFront(Lane* l) {
+    l->front = (l->front + 1) & l->mask;
+    l->count--;
+}
+
 int queueRemove(Lane* l, Vehicle* out) {
+    while (l->count > 0 && l->isRemoved[l->front]) {
+        popFront(l);
+        l->removedCount--;
+    }
     if (l->count == 0) return 0;
-    *out = l->data[l->front];
-    l->front = (l->front + 1) % MAX_QUEUE;
-    l->count--;
+    copySlotToVehicle(l, l->front, out);
+    popFront(l);
+    return 1;
+}
+
+int queueMarkRemoved(Lane* l, int index, Vehicle* out) {
+    if (index < 0 || index >= l->count) return 0;
+    int slot = QUEUE_SLOT(l, index);
+    if (l->isRemoved[slot]) return 0;
+    if (out) copySlotToVehicle(l, slot, out);
+    l->isRemoved[slot] = 1;
+    l->removedCount++;
+    return 1;
+}
+
+void queueCompact(Lane* l) {
+    if (l->removedCount == 0) return;
+
+    int kept = 0;
+    for (int i = 0; i < l->count; i++) {
+        int from = QUEUE_SLOT(l, i);
+        if (l->isRemoved[from]) continue;
+        if (kept != i) {
+            int to = QUEUE_SLOT(l, kept);
+            l->x[to] = l->x[from];
+            l->y[to] = l->y[from];
+            l->isStopped[to] = l->isStopped[from];
+            l->isRemoved[to] = 0;
+            l->waitMs[to] = l->waitMs[from];
+            l->info[to] = l->info[from];
+        }
+        kept++;
+    }
+    l->count = kept;
+    l->removedCount = 0;
+}
+
+int queueReadVehicleAt(const Lane* l, int index, Vehicle* out) {
+    if (index < 0 || index >= l->count) return 0;
+    copySlotToVehicle(l, QUEUE_SLOT(l, index), out);
+    return 1;
+}
+
+// Slots in logical order, tombstones included, as two runs of each array.
+static void putRing(const Lane* l, SnapshotBuffer* out, const void* base, size_t elemSize) {
+    int first = l->capacity - l->front;
+    if (first > l->count) first = l->count;
+    snapshotPut(out, (const char*)base + (size_t)l->front * elemSize, (size_t)first * elemSize);
+    snapshotPut(out, base, (size_t)(l->count - first) * elemSize);
+}
+
+void queueSaveSnapshot(const Lane* l, SnapshotBuffer* out) {
+    snapshotPut(out, &l->count, sizeof(l->count));
+    if (l->count == 0) return;
+    putRing(l, out, l->x, sizeof(float));
+    putRing(l, out, l->y, sizeof(float));
+    putRing(l, out, l->isStopped, sizeof(unsigned char));
+    putRing(l, out, l->isRemoved, sizeof(unsigned char));
+    putRing(l, out, l->waitMs, sizeof(unsigned int));
+    putRing(l, out, l->info, sizeof(VehicleInfo));
+}
+
+// The lane comes back with front = 0 and just enough capacity.
+int queueLoadSnapshot(Lane* l, SnapshotReader* in) {
+    int count;
+    if (!snapshotGet(in, &count, sizeof(count)) || count < 0) return 0;
+
+    queueRelease(l);
+    while (l->capacity < count) {
+        if (!queueGrow(l)) return 0;
+    }
+    if (count == 0) return 1;
+
+    int ok = snapshotGet(in, l->x, sizeof(float) * count)
+        && snapshotGet(in, l->y, sizeof(float) * count)
+        && snapshotGet(in, l->isStopped, sizeof(unsigned char) * count)
+        && snapshotGet(in, l->isRemoved, sizeof(unsigned char) * count)
+        && snapshotGet(in, l->waitMs, sizeof(unsigned int) * count)
+        && snapshotGet(in, l->info, sizeof(VehicleInfo) * count);
+    if (!ok) return 0;
+
+    l->count = count;
+    for (int i = 0; i < count; i++) l->removedCount += l->isRemoved[i];
+    return 1;
+}
+
+int vehicleBufferPush(VehicleBuffer* b, const Vehicle* v) {
+    if (b->count == b->capacity) {
+        int capacity = b->capacity ? b->capacity * 2 : LANE_INITIAL_CAPACITY;
+        Vehicle* items = realloc(b->items, sizeof(Vehicle) * capacity);
+        if (!items) return 0;
+        b->items = items;
+        b->capacity = capacity;
+    }
+    b->items[b->count++] = *v;
     return 1;
 }
 
-Vehicle* queueGetVehicleAt(Lane* l, int index) {
-    if (index < 0 || index >= l->count) return NULL;
-    int idx = (l->front + index) % MAX_QUEUE;
-    return &l->data[idx];
+void vehicleBufferRelease(VehicleBuffer* b) {
+    free(b->items);
+    b->items = NULL;
+    b->count = 0;
+    b->capacity = 0;
 }
@@ -2,10 +2,22 @@
 #define QUEUE_H
 
 #include "types.h"
+#include "snapshot.h"
+
+// Physical slot of the index-th vehicle counted from the front.
+#define QUEUE_SLOT(l, index) (((l)->front + (index)) & (l)->mask)
 
 void queueInitialize(Lane* l);
+void queueRelease(Lane* l);
 int queueInsert(Lane* l, Vehicle v);
 int queueRemove(Lane* l, Vehicle* out);
-Vehicle* queueGetVehicleAt(Lane* l, int index);
+int queueMarkRemoved(Lane* l, int index, Vehicle* out);
+void queueCompact(Lane* l);
+int queueReadVehicleAt(const Lane* l, int index, Vehicle* out);
+void queueSaveSnapshot(const Lane* l, SnapshotBuffer* out);
+int queueLoadSnapshot(Lane* l, SnapshotReader* in);
+
+int vehicleBufferPush(VehicleBuffer* b, const Vehicle* v);
+void vehicleBufferRelease(VehicleBuffer* b);
 
 #endif // QUEUE_H
@@ -0,0 +1,25 @@
+#include "random.h"
+
+void simRandomSeed(SimRandom* r, unsigned long long seed) {
+    // splitmix64 spreads nearby seeds apart and never yields a zero state.
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    r->state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+unsigned int simRandomNext(SimRandom* r) {
+    unsigned long long x = r->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    r->state = x;
+    return (unsigned int)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Uniform integer in [lo, hi].
+int simRandomRange(SimRandom* r, int lo, int hi) {
+    unsigned int span = (unsigned int)(hi - lo) + 1;
+    return lo + (int)(((unsigned long long)simRandomNext(r) * span) >> 32);
+}
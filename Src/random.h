@@ -0,0 +1,14 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+// Small seedable PRNG (xorshift64*) so every run with the same seed makes
+// the same choices, independent of the C library's rand().
+typedef struct {
+    unsigned long long state;
+} SimRandom;
+
+void simRandomSeed(SimRandom* r, unsigned long long seed);
+unsigned int simRandomNext(SimRandom* r);
+int simRandomRange(SimRandom* r, int lo, int hi);
+
+#endif // RANDOM_H
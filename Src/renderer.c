@@ -98,70 +98,271 @@ void renderRoadNetwork(SDL_Renderer* renderer) {
     SDL_RenderFillRect(renderer, &edgeW);
 }
 
-void renderSingleVehicle(SDL_Renderer* renderer, Vehicle* v, int r, int g, int b) {
-    if (!v) return;
+// Vehicles are gathered into one rectangle list per colour and submitted
+// with SDL_RenderFillRects/SDL_RenderDrawRects, so a frame costs a fixed
+// handful of draw calls however many vehicles are on screen.
+enum {
+    STYLE_LEFT_LANE,
+    STYLE_STRAIGHT_LANE,
+    STYLE_RIGHT_LANE,
+    STYLE_TRANSITION_MOVING,
+    STYLE_TRANSITION_STOPPED,
+    VEHICLE_STYLE_COUNT
+};
 
+static const SDL_Color vehicleStyleColors[VEHICLE_STYLE_COUNT] = {
+    {220, 80, 80, 255},
+    {80, 220, 80, 255},
+    {80, 120, 220, 255},
+    {255, 180, 0, 255},
+    {128, 90, 0, 255}
+};
+
+typedef struct {
+    SDL_Rect* rects;
+    int count, capacity;
+} RectBatch;
+
+static RectBatch bodyBatches[VEHICLE_STYLE_COUNT][2];
+static RectBatch outlineBatches[VEHICLE_STYLE_COUNT];
+static RectBatch windowBatch;
+
+static void pushRect(RectBatch* batch, SDL_Rect rect) {
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity ? batch->capacity * 2 : 64;
+        SDL_Rect* rects = realloc(batch->rects, sizeof(SDL_Rect) * capacity);
+        if (!rects) return;
+        batch->rects = rects;
+        batch->capacity = capacity;
+    }
+    batch->rects[batch->count++] = rect;
+}
+
+static void batchVehicle(int style, float x, float y, int fromRoad, int isStopped) {
     int width = 18;
     int height = 12;
 
-    int isVertical = (v->fromRoad == 0 || v->fromRoad == 2);
+    int isVertical = (fromRoad == 0 || fromRoad == 2);
     if (isVertical) {
         int temp = width;
         width = height;
         height = temp;
     }
 
-    if (v->isStopped) {
-        SDL_SetRenderDrawColor(renderer, r / 2, g / 2, b / 2, 255);
-    }
-    else {
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-    }
-
     SDL_Rect body = {
-        (int)(v->x - width / 2),
-        (int)(v->y - height / 2),
+        (int)(x - width / 2),
+        (int)(y - height / 2),
         width,
         height
     };
-    SDL_RenderFillRect(renderer, &body);
-
-    SDL_SetRenderDrawColor(renderer, r / 3, g / 3, b / 3, 255);
-    SDL_RenderDrawRect(renderer, &body);
+    pushRect(&bodyBatches[style][isStopped ? 1 : 0], body);
+    pushRect(&outlineBatches[style], body);
 
-    SDL_SetRenderDrawColor(renderer, 135, 206, 235, 180);
     if (isVertical) {
         SDL_Rect window = { body.x + 2, body.y + 2, body.w - 4, body.h / 3 };
-        SDL_RenderFillRect(renderer, &window);
+        pushRect(&windowBatch, window);
     }
     else {
         SDL_Rect window = { body.x + 2, body.y + 2, body.w / 3, body.h - 4 };
-        SDL_RenderFillRect(renderer, &window);
+        pushRect(&windowBatch, window);
     }
 }
 
-void renderLaneVehicles(SDL_Renderer* renderer, Lane* L, int r, int g, int b) {
+static void batchLaneVehicles(const Lane* L, int road, int style) {
     for (int i = 0; i < L->count; i++) {
-        Vehicle* v = queueGetVehicleAt(L, i);
-        if (v) {
-            renderSingleVehicle(renderer, v, r, g, b);
+        int s = QUEUE_SLOT(L, i);
+        batchVehicle(style, L->x[s], L->y[s], road, L->isStopped[s]);
+    }
+}
+
+static void batchTransitionVehicles(const TransitionPool* pool) {
+    for (int i = pool->head; i >= 0; i = pool->slots[i].next) {
+        const Vehicle* v = &pool->slots[i].v;
+        int style = v->isStopped ? STYLE_TRANSITION_STOPPED : STYLE_TRANSITION_MOVING;
+        batchVehicle(style, v->x, v->y, v->fromRoad, v->isStopped);
+    }
+}
+
+static void flushRectBatch(SDL_Renderer* renderer, RectBatch* batch, int fill) {
+    if (batch->count == 0) return;
+    if (fill) SDL_RenderFillRects(renderer, batch->rects, batch->count);
+    else SDL_RenderDrawRects(renderer, batch->rects, batch->count);
+    batch->count = 0;
+}
+
+void renderAllVehicles(SDL_Renderer* renderer, const Intersection* in) {
+    for (int r = 0; r < 4; r++) {
+        batchLaneVehicles(&in->roads[r].L1, r, STYLE_LEFT_LANE);
+        batchLaneVehicles(&in->roads[r].L2, r, STYLE_STRAIGHT_LANE);
+        batchLaneVehicles(&in->roads[r].L3, r, STYLE_RIGHT_LANE);
+    }
+    batchTransitionVehicles(&in->transitions);
+
+    for (int style = 0; style < VEHICLE_STYLE_COUNT; style++) {
+        SDL_Color c = vehicleStyleColors[style];
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, 255);
+        flushRectBatch(renderer, &bodyBatches[style][0], 1);
+        SDL_SetRenderDrawColor(renderer, c.r / 2, c.g / 2, c.b / 2, 255);
+        flushRectBatch(renderer, &bodyBatches[style][1], 1);
+    }
+
+    for (int style = 0; style < VEHICLE_STYLE_COUNT; style++) {
+        SDL_Color c = vehicleStyleColors[style];
+        SDL_SetRenderDrawColor(renderer, c.r / 3, c.g / 3, c.b / 3, 255);
+        flushRectBatch(renderer, &outlineBatches[style], 0);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 135, 206, 235, 180);
+    flushRectBatch(renderer, &windowBatch, 1);
+}
+
+void releaseVehicleBatches(void) {
+    for (int style = 0; style < VEHICLE_STYLE_COUNT; style++) {
+        free(bodyBatches[style][0].rects);
+        free(bodyBatches[style][1].rects);
+        free(outlineBatches[style].rects);
+    }
+    free(windowBatch.rects);
+    memset(bodyBatches, 0, sizeof(bodyBatches));
+    memset(outlineBatches, 0, sizeof(outlineBatches));
+    memset(&windowBatch, 0, sizeof(windowBatch));
+}
+
+// The background, trees and road markings never change, so they are drawn
+// once into a target texture and blitted each frame. The cache is rebuilt
+// when the output size changes or after invalidateStaticScene().
+static SDL_Texture* staticSceneTexture = NULL;
+static int staticSceneW = 0;
+static int staticSceneH = 0;
+
+// Signal discs are pre-rendered sprites: a red disc and a green disc with
+// its glow ring, both centred in a SIGNAL_SPRITE_SIZE square.
+#define SIGNAL_SPRITE_SIZE 21
+static SDL_Texture* redSignalSprite = NULL;
+static SDL_Texture* greenSignalSprite = NULL;
+
+// Set after the first failed attempt at a target texture, so a renderer
+// without target support goes straight to immediate drawing every frame.
+static int renderTargetsUnsupported = 0;
+
+static void drawStaticScene(SDL_Renderer* renderer) {
+    renderGradientBackground(renderer);
+    renderDecorativeTrees(renderer);
+    renderRoadNetwork(renderer);
+}
+
+static SDL_Texture* createTargetTexture(SDL_Renderer* renderer, int w, int h) {
+    if (renderTargetsUnsupported) return NULL;
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!texture) renderTargetsUnsupported = 1;
+    return texture;
+}
+
+static int rebuildStaticScene(SDL_Renderer* renderer, int w, int h) {
+    if (staticSceneTexture) SDL_DestroyTexture(staticSceneTexture);
+    staticSceneTexture = createTargetTexture(renderer, w, h);
+    if (!staticSceneTexture) return 0;
+
+    // Copied opaque, matching how the scene was drawn straight to the screen.
+    SDL_SetTextureBlendMode(staticSceneTexture, SDL_BLENDMODE_NONE);
+    if (SDL_SetRenderTarget(renderer, staticSceneTexture) != 0) {
+        SDL_DestroyTexture(staticSceneTexture);
+        staticSceneTexture = NULL;
+        renderTargetsUnsupported = 1;
+        return 0;
+    }
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    drawStaticScene(renderer);
+    SDL_SetRenderTarget(renderer, NULL);
+
+    staticSceneW = w;
+    staticSceneH = h;
+    return 1;
+}
+
+static SDL_Texture* buildSignalSprite(SDL_Renderer* renderer, Uint8 r, Uint8 g, Uint8 b, int withGlow) {
+    SDL_Texture* sprite = createTargetTexture(renderer, SIGNAL_SPRITE_SIZE, SIGNAL_SPRITE_SIZE);
+    if (!sprite) return NULL;
+    SDL_SetTextureBlendMode(sprite, SDL_BLENDMODE_BLEND);
+    if (SDL_SetRenderTarget(renderer, sprite) != 0) {
+        SDL_DestroyTexture(sprite);
+        renderTargetsUnsupported = 1;
+        return NULL;
+    }
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    // The glow ring was always drawn without blending, so it is opaque here too.
+    int c = SIGNAL_SPRITE_SIZE / 2;
+    SDL_SetRenderDrawColor(renderer, r, g, b, 255);
+    for (int dy = -10; dy <= 10; dy++) {
+        for (int dx = -10; dx <= 10; dx++) {
+            int d2 = dx * dx + dy * dy;
+            if (d2 <= 64 || (withGlow && d2 <= 100)) {
+                SDL_RenderDrawPoint(renderer, c + dx, c + dy);
+            }
         }
     }
+    SDL_SetRenderTarget(renderer, NULL);
+    return sprite;
 }
 
-void renderTransitionVehicles(SDL_Renderer* renderer) {
-    for (int i = 0; i < transitionCount; i++) {
-        Vehicle* v = &transitions[i].v;
-        if (v->isStopped) {
-            renderSingleVehicle(renderer, v, 128, 90, 0);
+static void drawSignalDisc(SDL_Renderer* renderer, int lightX, int lightY, int isGreen) {
+    for (int dy = -8; dy <= 8; dy++) {
+        for (int dx = -8; dx <= 8; dx++) {
+            if (dx * dx + dy * dy <= 64) {
+                SDL_RenderDrawPoint(renderer, lightX + dx, lightY + dy);
+            }
         }
-        else {
-            renderSingleVehicle(renderer, v, 255, 180, 0);
+    }
+
+    if (isGreen) {
+        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 100);
+        for (int dy = -10; dy <= 10; dy++) {
+            for (int dx = -10; dx <= 10; dx++) {
+                if (dx * dx + dy * dy <= 100 && dx * dx + dy * dy > 64) {
+                    SDL_RenderDrawPoint(renderer, lightX + dx, lightY + dy);
+                }
+            }
+        }
+    }
+}
+
+void renderStaticScene(SDL_Renderer* renderer) {
+    int w = SCREEN_W;
+    int h = SCREEN_H;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+
+    // No render-target support: fall back to immediate drawing.
+    if (renderTargetsUnsupported) {
+        drawStaticScene(renderer);
+        return;
+    }
+    if (!staticSceneTexture || w != staticSceneW || h != staticSceneH) {
+        if (!rebuildStaticScene(renderer, w, h)) {
+            drawStaticScene(renderer);
+            return;
         }
     }
+    SDL_RenderCopy(renderer, staticSceneTexture, NULL, NULL);
+}
+
+void invalidateStaticScene(void) {
+    if (staticSceneTexture) SDL_DestroyTexture(staticSceneTexture);
+    if (redSignalSprite) SDL_DestroyTexture(redSignalSprite);
+    if (greenSignalSprite) SDL_DestroyTexture(greenSignalSprite);
+    staticSceneTexture = NULL;
+    redSignalSprite = NULL;
+    greenSignalSprite = NULL;
+    staticSceneW = 0;
+    staticSceneH = 0;
 }
 
-void renderTrafficSignals(SDL_Renderer* renderer) {
+void renderTrafficSignals(SDL_Renderer* renderer, const Intersection* in) {
+    if (!redSignalSprite) redSignalSprite = buildSignalSprite(renderer, 255, 0, 0, 0);
+    if (!greenSignalSprite) greenSignalSprite = buildSignalSprite(renderer, 0, 255, 0, 1);
+
     int cx = SCREEN_W / 2;
     int cy = SCREEN_H / 2;
     int roadHalf = ROAD_W / 2;
@@ -182,32 +383,99 @@ void renderTrafficSignals(SDL_Renderer* renderer) {
         SDL_Rect housing = { lightPositions[i][0], lightPositions[i][1], 35, 30 };
         SDL_RenderFillRect(renderer, &housing);
 
-        if (i == currentGreen && lightState == GREEN_LIGHT) {
-            SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+        int isGreen = (i == in->currentGreen && in->lightState == GREEN_LIGHT);
+        int lightX = lightPositions[i][0] + 17;
+        int lightY = lightPositions[i][1] + 15;
+
+        SDL_Texture* sprite = isGreen ? greenSignalSprite : redSignalSprite;
+        if (sprite) {
+            SDL_Rect dst = {
+                lightX - SIGNAL_SPRITE_SIZE / 2,
+                lightY - SIGNAL_SPRITE_SIZE / 2,
+                SIGNAL_SPRITE_SIZE,
+                SIGNAL_SPRITE_SIZE
+            };
+            SDL_RenderCopy(renderer, sprite, NULL, &dst);
         }
         else {
-            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+            SDL_SetRenderDrawColor(renderer, isGreen ? 0 : 255, isGreen ? 255 : 0, 0, 255);
+            drawSignalDisc(renderer, lightX, lightY, isGreen);
         }
+    }
+}
 
-        int lightX = lightPositions[i][0] + 17;
-        int lightY = lightPositions[i][1] + 15;
-        for (int dy = -8; dy <= 8; dy++) {
-            for (int dx = -8; dx <= 8; dx++) {
-                if (dx * dx + dy * dy <= 64) {
-                    SDL_RenderDrawPoint(renderer, lightX + dx, lightY + dy);
-                }
-            }
-        }
+#ifdef SIM_PROFILE
+// One cached text texture per overlay line, rebuilt only when the profiler
+// publishes a new window.
+#define PROFILE_OVERLAY_LINES (PROFILE_PHASE_COUNT + 1)
+static SDL_Texture* overlayLines[PROFILE_OVERLAY_LINES];
+static int overlayLineW[PROFILE_OVERLAY_LINES];
+static int overlayLineH[PROFILE_OVERLAY_LINES];
+static int overlayLineCount = 0;
+static unsigned long long overlayGeneration = 0;
 
-        if (i == currentGreen && lightState == GREEN_LIGHT) {
-            SDL_SetRenderDrawColor(renderer, 0, 255, 0, 100);
-            for (int dy = -10; dy <= 10; dy++) {
-                for (int dx = -10; dx <= 10; dx++) {
-                    if (dx * dx + dy * dy <= 100 && dx * dx + dy * dy > 64) {
-                        SDL_RenderDrawPoint(renderer, lightX + dx, lightY + dy);
-                    }
-                }
-            }
-        }
+static void releaseOverlayLines(void) {
+    for (int i = 0; i < overlayLineCount; i++) SDL_DestroyTexture(overlayLines[i]);
+    overlayLineCount = 0;
+}
+
+static void addOverlayLine(SDL_Renderer* renderer, TTF_Font* font, const char* text) {
+    SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface* surface = TTF_RenderText_Blended(font, text, white);
+    if (!surface) return;
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) {
+        overlayLines[overlayLineCount] = texture;
+        overlayLineW[overlayLineCount] = surface->w;
+        overlayLineH[overlayLineCount] = surface->h;
+        overlayLineCount++;
+    }
+    SDL_FreeSurface(surface);
+}
+
+static void rebuildOverlayLines(SDL_Renderer* renderer, TTF_Font* font) {
+    releaseOverlayLines();
+    addOverlayLine(renderer, font, "phase            p50 us   p99 us   max us");
+
+    const ProfileSummary* latest = profilerLatest();
+    char text[96];
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        if (latest[p].count == 0) continue;
+        snprintf(text, sizeof(text), "%-16s %8.1f %8.1f %8.1f", profilePhaseName((ProfilePhase)p),
+            latest[p].p50Us, latest[p].p99Us, latest[p].maxUs);
+        addOverlayLine(renderer, font, text);
+    }
+    overlayGeneration = profilerGeneration();
+}
+
+void renderProfilerOverlay(SDL_Renderer* renderer, TTF_Font* font) {
+    if (!font) return;
+    if (overlayGeneration != profilerGeneration() || overlayLineCount == 0) {
+        rebuildOverlayLines(renderer, font);
+    }
+
+    int width = 0, height = 0;
+    for (int i = 0; i < overlayLineCount; i++) {
+        if (overlayLineW[i] > width) width = overlayLineW[i];
+        height += overlayLineH[i];
+    }
+
+    SDL_Rect background = { 8, 8, width + 12, height + 12 };
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+    SDL_RenderFillRect(renderer, &background);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    int y = background.y + 6;
+    for (int i = 0; i < overlayLineCount; i++) {
+        SDL_Rect dst = { background.x + 6, y, overlayLineW[i], overlayLineH[i] };
+        SDL_RenderCopy(renderer, overlayLines[i], NULL, &dst);
+        y += overlayLineH[i];
     }
 }
+
+void releaseProfilerOverlay(void) {
+    releaseOverlayLines();
+    overlayGeneration = 0;
+}
+#endif
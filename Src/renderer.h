@@ -1,14 +1,23 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <SDL.h>
+#include <SDL_ttf.h>
 #include "types.h"
+#include "profiler.h"
 
 void renderGradientBackground(SDL_Renderer* renderer);
 void renderDecorativeTrees(SDL_Renderer* renderer);
 void renderRoadNetwork(SDL_Renderer* renderer);
-void renderSingleVehicle(SDL_Renderer* renderer, Vehicle* v, int r, int g, int b);
-void renderLaneVehicles(SDL_Renderer* renderer, Lane* L, int r, int g, int b);
-void renderTransitionVehicles(SDL_Renderer* renderer);
-void renderTrafficSignals(SDL_Renderer* renderer);
+void renderStaticScene(SDL_Renderer* renderer);
+void invalidateStaticScene(void);
+void renderAllVehicles(SDL_Renderer* renderer, const Intersection* in);
+void releaseVehicleBatches(void);
+void renderTrafficSignals(SDL_Renderer* renderer, const Intersection* in);
+
+#ifdef SIM_PROFILE
+void renderProfilerOverlay(SDL_Renderer* renderer, TTF_Font* font);
+void releaseProfilerOverlay(void);
+#endif
 
 #endif // RENDERER_H
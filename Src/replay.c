@@ -0,0 +1,179 @@
+#include "replay.h"
+#include "fileio.h"
+#include "random.h"
+#include <ctype.h>
+#include <limits.h>
+
+static ReplayEvent* events = NULL;
+static int eventCount = 0;
+static int nextEvent = 0;
+static int active = 0;
+
+static int parseRoadLetter(const char* s) {
+    char c = (char)toupper((unsigned char)s[0]);
+    if (c < 'A' || c > 'D' || (s[1] && s[1] != ':' && !isspace((unsigned char)s[1]))) return -1;
+    return c - 'A';
+}
+
+// PLATE:ROAD:LANE[:ARRIVAL_MS]; ROAD is A-D, LANE is 1-3.
+static int parseReplayLine(char* line, ReplayEvent* out, int* hasArrival) {
+    char* fields[4] = { NULL, NULL, NULL, NULL };
+    int count = 0;
+    char* p = line;
+    while (*p && isspace((unsigned char)*p)) p++;
+    if (*p == '\0' || *p == '#') return 0;
+
+    fields[count++] = p;
+    for (; *p && count < 4; p++) {
+        if (*p == ':') {
+            *p = '\0';
+            fields[count++] = p + 1;
+        }
+    }
+    if (count < 3) return 0;
+
+    int plateLength = (int)strlen(fields[0]);
+    if (plateLength == 0) return 0;
+    if (plateLength > NAME_MAX - 1) plateLength = NAME_MAX - 1;
+
+    int road = parseRoadLetter(fields[1]);
+    char* end;
+    long lane = strtol(fields[2], &end, 10);
+    if (road < 0 || end == fields[2] || lane < 1 || lane > 3) return 0;
+
+    memcpy(out->rec.name, fields[0], plateLength);
+    out->rec.name[plateLength] = '\0';
+    out->rec.lane = (int)lane;
+    out->road = road;
+
+    *hasArrival = 0;
+    if (count == 4) {
+        unsigned long long arrival = strtoull(fields[3], &end, 10);
+        if (end != fields[3]) {
+            out->arrivalMs = arrival;
+            *hasArrival = 1;
+        }
+    }
+    return 1;
+}
+
+static int compareReplayEvents(const void* a, const void* b) {
+    const ReplayEvent* x = a;
+    const ReplayEvent* y = b;
+    if (x->arrivalMs != y->arrivalMs) return x->arrivalMs < y->arrivalMs ? -1 : 1;
+    return x->rec.id - y->rec.id;
+}
+
+// Lines without an arrival time are spaced by a seeded random gap after the
+// previous vehicle, so a plain dataset becomes a repeatable scenario.
+int replayLoad(const char* path, unsigned long long seed) {
+    replayRelease();
+
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+
+    SimRandom gaps;
+    simRandomSeed(&gaps, seed ^ 0xA24BAED4963EE407ULL);
+
+    int capacity = 0;
+    unsigned long long lastArrival = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        ReplayEvent e;
+        int hasArrival;
+        if (!parseReplayLine(line, &e, &hasArrival)) continue;
+
+        if (!hasArrival) {
+            e.arrivalMs = lastArrival + (unsigned long long)simRandomRange(&gaps, REPLAY_MIN_GAP_MS, REPLAY_MAX_GAP_MS);
+        }
+        lastArrival = e.arrivalMs;
+        e.rec.id = eventCount + 1;
+
+        if (eventCount == capacity) {
+            int grown = capacity ? capacity * 2 : 256;
+            ReplayEvent* resized = realloc(events, sizeof(ReplayEvent) * grown);
+            if (!resized) break;
+            events = resized;
+            capacity = grown;
+        }
+        events[eventCount++] = e;
+    }
+    fclose(f);
+
+    // Recorded timestamps may be out of order; ids keep ties stable.
+    qsort(events, eventCount, sizeof(ReplayEvent), compareReplayEvents);
+    nextEvent = 0;
+    active = 1;
+    return eventCount;
+}
+
+void replayRelease(void) {
+    free(events);
+    events = NULL;
+    eventCount = 0;
+    nextEvent = 0;
+    active = 0;
+}
+
+int replayIsActive(void) {
+    return active;
+}
+
+int replayIsFinished(void) {
+    return active && nextEvent >= eventCount;
+}
+
+int replaySpawnDue(unsigned long long nowMs) {
+    int spawned = 0;
+    while (nextEvent < eventCount && events[nextEvent].arrivalMs <= nowMs) {
+        // A full pending buffer holds the rest back until a later tick.
+        if (!spawnAtNetworkEntry(events[nextEvent].road, &events[nextEvent].rec)) break;
+        nextEvent++;
+        spawned++;
+    }
+    return spawned;
+}
+
+unsigned long long replayNextArrivalMs(void) {
+    if (nextEvent >= eventCount) return ULLONG_MAX;
+    return events[nextEvent].arrivalMs;
+}
+
+int replayEventCount(void) {
+    return eventCount;
+}
+
+// Arrival times and roads of the whole dataset, to tell a snapshot of one
+// replay from another with the same number of events.
+static unsigned long long fingerprintEvents(void) {
+    unsigned long long h = 1469598103934665603ULL;
+    for (int i = 0; i < eventCount; i++) {
+        h = (h ^ events[i].arrivalMs) * 1099511628211ULL;
+        h = (h ^ (unsigned long long)events[i].road) * 1099511628211ULL;
+    }
+    return h;
+}
+
+void replaySaveSnapshot(SnapshotBuffer* out) {
+    unsigned long long fingerprint = fingerprintEvents();
+    snapshotPut(out, &active, sizeof(active));
+    snapshotPut(out, &eventCount, sizeof(eventCount));
+    snapshotPut(out, &fingerprint, sizeof(fingerprint));
+    snapshotPut(out, &nextEvent, sizeof(nextEvent));
+}
+
+SnapshotStatus replayLoadSnapshot(SnapshotReader* in) {
+    int savedActive, savedCount, savedNext;
+    unsigned long long savedFingerprint;
+    if (!snapshotGet(in, &savedActive, sizeof(savedActive))
+        || !snapshotGet(in, &savedCount, sizeof(savedCount))
+        || !snapshotGet(in, &savedFingerprint, sizeof(savedFingerprint))
+        || !snapshotGet(in, &savedNext, sizeof(savedNext))) return SNAPSHOT_CORRUPT;
+
+    if (savedActive != active || savedCount != eventCount || savedFingerprint != fingerprintEvents()) {
+        return SNAPSHOT_INPUT_MISMATCH;
+    }
+    if (savedNext < 0 || savedNext > eventCount) return SNAPSHOT_CORRUPT;
+    nextEvent = savedNext;
+    return SNAPSHOT_OK;
+}
@@ -0,0 +1,25 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "types.h"
+#include "snapshot.h"
+
+// One vehicle from a recorded dataset, due at arrivalMs of simulated time.
+typedef struct {
+    unsigned long long arrivalMs;
+    int road;
+    VehicleRecord rec;
+} ReplayEvent;
+
+int replayLoad(const char* path, unsigned long long seed);
+void replayRelease(void);
+int replayIsActive(void);
+int replayIsFinished(void);
+int replaySpawnDue(unsigned long long nowMs);
+int replayEventCount(void);
+// Arrival time of the next event still to spawn; ULLONG_MAX once none is left.
+unsigned long long replayNextArrivalMs(void);
+void replaySaveSnapshot(SnapshotBuffer* out);
+SnapshotStatus replayLoadSnapshot(SnapshotReader* in);
+
+#endif // REPLAY_H
@@ -0,0 +1,246 @@
+#include "signalcontrol.h"
+#include "intersection.h"
+#include "queue.h"
+#include <limits.h>
+
+// Fixed-time round robin, the original behaviour.
+static int chooseFixed(const SignalObservation* obs, int current, unsigned long long greenMs) {
+    (void)obs;
+    if (greenMs >= LIGHT_CYCLE_MS) return (current + 1) % 4;
+    return current;
+}
+
+// Index of the largest value, scanning in cycle order after current so ties
+// go to the next approach in line; skipCurrent leaves current out.
+static int pickLargest(const float* value, int current, int skipCurrent) {
+    int best = current;
+    float bestValue = skipCurrent ? -1.0f : value[current];
+    for (int k = 1; k < 4; k++) {
+        int r = (current + k) % 4;
+        if (value[r] > bestValue) {
+            best = r;
+            bestValue = value[r];
+        }
+    }
+    return best;
+}
+
+// Serve the current approach until it empties (or hits the maximum green),
+// then hand green to the longest queue.
+static int chooseLongestQueue(const SignalObservation* obs, int current, unsigned long long greenMs) {
+    if (greenMs < SIGNAL_MIN_GREEN_MS) return current;
+    if (obs->queue[current] > 0 && greenMs < SIGNAL_MAX_GREEN_MS) return current;
+
+    float queue[4];
+    for (int r = 0; r < 4; r++) queue[r] = (float)obs->queue[r];
+
+    int best = pickLargest(queue, current, 1);
+    return obs->queue[best] > 0 ? best : current;
+}
+
+// Switch whenever another approach has more pressure. Exits never back up
+// here, so the downstream term of max-pressure is zero and pressure is the
+// wait-weighted queue; long waits keep any approach from starving.
+static int chooseMaxPressure(const SignalObservation* obs, int current, unsigned long long greenMs) {
+    if (greenMs < SIGNAL_MIN_GREEN_MS) return current;
+
+    int best = pickLargest(obs->pressure, current, greenMs >= SIGNAL_MAX_GREEN_MS);
+    if (obs->pressure[best] <= 0.0f) return current;
+    if (best != current && obs->pressure[best] <= obs->pressure[current]) return current;
+    return best;
+}
+
+static const SignalPolicyDef policies[SIGNAL_POLICY_COUNT] = {
+    { "fixed", chooseFixed },
+    { "lqf", chooseLongestQueue },
+    { "pressure", chooseMaxPressure }
+};
+
+// One pass over every approach: ages stopped vehicles, stamps first stops
+// and sums the demand.
+static void observeApproaches(RoadData* roads, SignalObservation* obs, unsigned long long nowMs) {
+    for (int r = 0; r < 4; r++) {
+        Lane* lanes[2] = { &roads[r].L1, &roads[r].L2 };
+        float waitedMs = 0.0f;
+
+        obs->queue[r] = 0;
+        obs->stopped[r] = 0;
+        for (int k = 0; k < 2; k++) {
+            Lane* L = lanes[k];
+            obs->queue[r] += L->count;
+            for (int i = 0; i < L->count; i++) {
+                int s = QUEUE_SLOT(L, i);
+                if (!L->isStopped[s]) continue;
+                if (L->waitMs[s] == 0) L->info[s].times.firstStopMs = (unsigned int)nowMs;
+                L->waitMs[s] += SIM_TICK_MS;
+                waitedMs += (float)L->waitMs[s];
+                obs->stopped[r]++;
+            }
+        }
+        obs->pressure[r] = obs->queue[r] + waitedMs / 1000.0f;
+    }
+}
+
+// Roads that are green or empty are not waiting; the rest keep the time
+// they started waiting.
+static void trackRoadWaits(SignalState* s, int currentGreen, const SignalObservation* obs, unsigned long long nowMs, SignalPolicyStats* st) {
+    for (int r = 0; r < 4; r++) {
+        if (r == currentGreen || obs->queue[r] == 0) {
+            s->waitingSinceMs[r] = nowMs;
+            continue;
+        }
+        unsigned long long waited = nowMs - s->waitingSinceMs[r];
+        if (s->priority.enabled && r != s->priority.road && waited > st->longestWaitMs) st->longestWaitMs = waited;
+    }
+}
+
+// Overrides the policy's choice while the priority lane is backed up. The
+// starvation guard runs whenever priority mode is on, so waits built up
+// during preemption cannot carry over into normal rotation unchecked.
+static int applyPriorityService(Intersection* in, int choice, unsigned long long nowMs, unsigned long long greenMs, SignalPolicyStats* st) {
+    SignalState* s = &in->signal;
+    const SignalPriority* priority = &s->priority;
+    const Lane* L = priority->lane == 1 ? &in->roads[priority->road].L1 : &in->roads[priority->road].L2;
+
+    if (!s->priorityActive && L->count >= priority->enterCount) {
+        s->priorityActive = 1;
+        st->priorityEngagements++;
+    }
+    else if (s->priorityActive && L->count <= priority->exitCount) {
+        s->priorityActive = 0;
+    }
+    if (s->priorityActive) st->priorityMs += SIM_TICK_MS;
+    if (greenMs < SIGNAL_MIN_GREEN_MS) return s->priorityActive ? in->currentGreen : choice;
+
+    // The road waiting longest past maxWaitMs goes next.
+    int starved = -1;
+    unsigned long long longest = 0;
+    for (int r = 0; r < 4; r++) {
+        if (r == priority->road) continue;
+        unsigned long long waited = nowMs - s->waitingSinceMs[r];
+        if (waited >= priority->maxWaitMs && waited > longest) {
+            starved = r;
+            longest = waited;
+        }
+    }
+    if (starved >= 0) {
+        if (starved != in->currentGreen) st->starvationOverrides++;
+        return starved;
+    }
+    return s->priorityActive ? priority->road : choice;
+}
+
+// A NULL priority leaves priority service off.
+void signalControllerInitialize(SignalState* s, SignalPolicy policy, const SignalPriority* priority) {
+    memset(s, 0, sizeof(*s));
+    s->policy = policy;
+    if (priority) s->priority = *priority;
+    if (s->priority.lane != 1) s->priority.lane = 2;
+    if (s->priority.exitCount > s->priority.enterCount) s->priority.exitCount = s->priority.enterCount;
+}
+
+void signalControllerUpdate(Intersection* in, unsigned long long nowMs) {
+    SignalState* s = &in->signal;
+    SignalObservation obs;
+    observeApproaches(in->roads, &obs, nowMs);
+
+    SignalPolicyStats* st = &s->stats[s->policy];
+    st->activeMs += SIM_TICK_MS;
+
+    int othersWaiting = 0;
+    for (int r = 0; r < 4; r++) {
+        if (r != in->currentGreen && obs.queue[r] > 0) othersWaiting = 1;
+    }
+    if (obs.queue[in->currentGreen] == 0 && othersWaiting) st->idleGreenMs += SIM_TICK_MS;
+
+    trackRoadWaits(s, in->currentGreen, &obs, nowMs, st);
+
+    unsigned long long greenMs = nowMs - s->lastSwitchMs;
+    int next = policies[s->policy].chooseGreen(&obs, in->currentGreen, greenMs);
+    if (s->priority.enabled) next = applyPriorityService(in, next, nowMs, greenMs, st);
+    if (next >= 0 && next < 4 && next != in->currentGreen) {
+        st->switches++;
+        metricsRecordPhase(&in->metrics, in->currentGreen, greenMs);
+        in->currentGreen = next;
+        s->lastSwitchMs = nowMs;
+    }
+}
+
+// With every approach empty the adaptive policies keep the current green
+// and priority service stays off, unless it is already on or a zero
+// threshold would turn it on again each tick.
+int signalControllerCanSkipIdle(const SignalState* s) {
+    if (s->priorityActive) return 0;
+    return !s->priority.enabled || s->priority.enterCount > 0;
+}
+
+// Raw time from which the next update switches an idle intersection;
+// ULLONG_MAX when it never does.
+unsigned long long signalControllerNextIdleSwitchMs(const SignalState* s) {
+    if (s->policy != SIGNAL_POLICY_FIXED) return ULLONG_MAX;
+    return s->lastSwitchMs + LIGHT_CYCLE_MS;
+}
+
+// The switch signalControllerUpdate() makes in the tick at nowMs.
+void signalControllerSwitchIdle(Intersection* in, unsigned long long nowMs) {
+    SignalState* s = &in->signal;
+    unsigned long long greenMs = nowMs - s->lastSwitchMs;
+    s->stats[s->policy].switches++;
+    metricsRecordPhase(&in->metrics, in->currentGreen, greenMs);
+    in->currentGreen = (in->currentGreen + 1) % 4;
+    s->lastSwitchMs = nowMs;
+}
+
+// What the idle updates for the ticks in [fromMs, toMs) leave behind,
+// apart from the switches.
+void signalControllerSkipIdleTicks(SignalState* s, unsigned long long fromMs, unsigned long long toMs) {
+    if (toMs <= fromMs) return;
+    s->stats[s->policy].activeMs += toMs - fromMs;
+    for (int r = 0; r < 4; r++) s->waitingSinceMs[r] = toMs - SIM_TICK_MS;
+}
+
+void signalControllerRecordCleared(SignalState* s, int count) {
+    s->stats[s->policy].cleared += count;
+}
+
+// Sums across intersections; activeMs becomes intersection-time, so rates
+// derived from it are per intersection.
+void signalStatsAccumulate(SignalPolicyStats* total, const SignalPolicyStats* add) {
+    total->activeMs += add->activeMs;
+    total->cleared += add->cleared;
+    total->switches += add->switches;
+    total->idleGreenMs += add->idleGreenMs;
+    total->priorityMs += add->priorityMs;
+    total->priorityEngagements += add->priorityEngagements;
+    total->starvationOverrides += add->starvationOverrides;
+    if (add->longestWaitMs > total->longestWaitMs) total->longestWaitMs = add->longestWaitMs;
+}
+
+void signalControllerPrintStats(const SignalPolicyStats* stats, const SignalPriority* priority) {
+    for (int p = 0; p < SIGNAL_POLICY_COUNT; p++) {
+        const SignalPolicyStats* st = &stats[p];
+        if (st->activeMs == 0) continue;
+
+        double minutes = st->activeMs / 60000.0;
+        printf("Signal policy %-8s: %llu cleared in %.1f min (%.1f/min), %llu switches, idle green %.1f%%\n",
+            policies[p].name, st->cleared, minutes, st->cleared / minutes, st->switches,
+            100.0 * st->idleGreenMs / st->activeMs);
+        if (priority && priority->enabled) {
+            printf("  priority road %c L%d: engaged %llu times, %.1f%% of the time, %llu starvation overrides, longest other wait %.1f s\n",
+                'A' + priority->road, priority->lane, st->priorityEngagements, 100.0 * st->priorityMs / st->activeMs,
+                st->starvationOverrides, st->longestWaitMs / 1000.0);
+        }
+    }
+}
+
+const char* signalPolicyName(SignalPolicy policy) {
+    if (policy < 0 || policy >= SIGNAL_POLICY_COUNT) return "unknown";
+    return policies[policy].name;
+}
+
+int signalPolicyFromName(const char* name) {
+    for (int p = 0; p < SIGNAL_POLICY_COUNT; p++) {
+        if (strcmp(policies[p].name, name) == 0) return p;
+    }
+    return -1;
+}
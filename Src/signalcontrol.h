@@ -0,0 +1,74 @@
+#ifndef SIGNALCONTROL_H
+#define SIGNALCONTROL_H
+
+#include "types.h"
+
+typedef enum {
+    SIGNAL_POLICY_FIXED,
+    SIGNAL_POLICY_LONGEST_QUEUE,
+    SIGNAL_POLICY_MAX_PRESSURE,
+    SIGNAL_POLICY_COUNT
+} SignalPolicy;
+
+// Per-approach demand gathered once per tick from each road's L1 and L2.
+typedef struct {
+    int queue[4];        // vehicles in L1 + L2
+    int stopped[4];      // of those, currently stopped
+    float pressure[4];   // queue plus seconds waited by stopped vehicles
+} SignalObservation;
+
+// A policy returns the road that should be green; returning current keeps it.
+typedef int (*SignalPolicyFunc)(const SignalObservation* obs, int current, unsigned long long greenMs);
+
+typedef struct {
+    const char* name;
+    SignalPolicyFunc chooseGreen;
+} SignalPolicyDef;
+
+// Priority service: once the designated lane holds enterCount vehicles its
+// road preempts whatever the policy chose, until the lane drains to
+// exitCount. No other waiting road goes unserved for longer than maxWaitMs.
+typedef struct {
+    int enabled;
+    int road;
+    int lane;   // 1 or 2; L3 never waits for a light
+    int enterCount;
+    int exitCount;
+    unsigned long long maxWaitMs;
+} SignalPriority;
+
+typedef struct {
+    unsigned long long activeMs;
+    unsigned long long cleared;
+    unsigned long long switches;
+    unsigned long long idleGreenMs;   // green on an empty approach while another waits
+    unsigned long long priorityMs;
+    unsigned long long priorityEngagements;
+    unsigned long long starvationOverrides;
+    unsigned long long longestWaitMs;  // longest any non-priority road waited for green
+} SignalPolicyStats;
+
+// Controller state for one intersection.
+typedef struct {
+    SignalPolicy policy;
+    SignalPriority priority;
+    int priorityActive;
+    unsigned long long lastSwitchMs;
+    unsigned long long waitingSinceMs[4];
+    SignalPolicyStats stats[SIGNAL_POLICY_COUNT];
+} SignalState;
+
+void signalControllerInitialize(SignalState* s, SignalPolicy policy, const SignalPriority* priority);
+void signalControllerUpdate(Intersection* in, unsigned long long nowMs);
+void signalControllerRecordCleared(SignalState* s, int count);
+// Idle intersections (see intersectionIsIdle) for the event-driven engine.
+int signalControllerCanSkipIdle(const SignalState* s);
+unsigned long long signalControllerNextIdleSwitchMs(const SignalState* s);
+void signalControllerSwitchIdle(Intersection* in, unsigned long long nowMs);
+void signalControllerSkipIdleTicks(SignalState* s, unsigned long long fromMs, unsigned long long toMs);
+void signalStatsAccumulate(SignalPolicyStats* total, const SignalPolicyStats* add);
+void signalControllerPrintStats(const SignalPolicyStats* stats, const SignalPriority* priority);
+const char* signalPolicyName(SignalPolicy policy);
+int signalPolicyFromName(const char* name);
+
+#endif // SIGNALCONTROL_H
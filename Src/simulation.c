@@ -0,0 +1,338 @@
+#include "simulation.h"
+#include "globals.h"
+#include "queue.h"
+#include "fileio.h"
+#include "ingest.h"
+#include "replay.h"
+#include "workerpool.h"
+#include "platform.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "eventqueue.h"
+#include <limits.h>
+
+static SimulationStats stats;
+static unsigned long long lastFileCheck = 0;
+static unsigned long long stepTimeMs = 0;
+static int parallelLanes = 0;
+static EventQueue idleEvents;
+
+static void stepIntersections(void* ctx, int begin, int end) {
+    (void)ctx;
+    for (int i = begin; i < end; i++) {
+        intersectionStep(&network.cells[i], stepTimeMs);
+    }
+}
+
+static void beginIntersections(void* ctx, int begin, int end) {
+    (void)ctx;
+    for (int i = begin; i < end; i++) {
+        intersectionBeginStep(&network.cells[i], stepTimeMs);
+    }
+}
+
+static void updateLanes(void* ctx, int begin, int end) {
+    (void)ctx;
+    for (int t = begin; t < end; t++) {
+        intersectionUpdateLane(&network.cells[t / INTERSECTION_LANES], t % INTERSECTION_LANES);
+    }
+}
+
+static void finishIntersections(void* ctx, int begin, int end) {
+    (void)ctx;
+    for (int i = begin; i < end; i++) {
+        intersectionFinishStep(&network.cells[i], stepTimeMs);
+    }
+}
+
+void simulationShutdown(void) {
+    workerPoolStop();
+    eventQueueRelease(&idleEvents);
+    metricsFinish(simulationTimeMs);
+    intersectionGridRelease(&network);
+}
+
+// Intersection 0 keeps the run seed itself, so a single intersection
+// replays exactly as before the grid existed.
+int simulationInitialize(const SimulationConfig* config) {
+    if (!intersectionGridCreate(&network, config->rows, config->cols)) return 0;
+    for (int i = 0; i < network.count; i++) {
+        unsigned long long seed = config->seed ^ (0x9E3779B97F4A7C15ULL * (unsigned long long)i);
+        intersectionInitialize(&network.cells[i], seed, config->policy, &config->priority);
+    }
+
+    // Lane mode has twelve tasks per intersection to share out.
+    parallelLanes = config->parallelLanes;
+    int tasks = parallelLanes ? network.count * INTERSECTION_LANES : network.count;
+    int threads = config->threads > 0 ? config->threads : platformCpuCount();
+    if (threads > tasks) threads = tasks;
+    workerPoolStart(threads);
+
+    simulationTimeMs = 0;
+    lastFileCheck = 0;
+    memset(&stats, 0, sizeof(stats));
+    metricsReset();
+
+    resetInputCursors();
+    if (!replayIsActive() && !ingestSharedRingActive()) loadVehiclesFromInputFiles();
+    return 1;
+}
+
+void simulationStep(void) {
+    unsigned long long now = simulationTimeMs;
+    PROFILE_BEGIN(PROFILE_TICK);
+
+    // With the ingest thread running, file I/O happens off this thread and
+    // the tick only drains what has been parsed since the last one.
+    PROFILE_BEGIN(PROFILE_INGEST);
+    spawnPendingVehicles();
+    if (replayIsActive()) {
+        replaySpawnDue(now);
+    }
+    else if (ingestSharedRingActive()) {
+        ingestDrainSharedRing();
+    }
+    else {
+        if (ingestIsRunning()) {
+            ingestDrain();
+        }
+        else if (now - lastFileCheck >= FILE_POLL_INTERVAL_MS) {
+            loadVehiclesFromInputFiles();
+            lastFileCheck = now;
+        }
+        publishInputBackpressure();
+    }
+    PROFILE_END(PROFILE_INGEST);
+
+    // Each intersection only touches its own state, then vehicles cross
+    // borders on this thread once every step has finished.
+    stepTimeMs = now;
+    if (parallelLanes) {
+        // Queue lengths vary a lot between lanes, so lane tasks are stolen
+        // rather than split evenly. L3 exits land in per-road buffers that
+        // the hand-off below drains in a fixed order.
+        workerPoolRun(beginIntersections, NULL, network.count);
+        workerPoolRunStealing(updateLanes, NULL, network.count * INTERSECTION_LANES);
+        workerPoolRun(finishIntersections, NULL, network.count);
+    }
+    else {
+        workerPoolRun(stepIntersections, NULL, network.count);
+    }
+    PROFILE_BEGIN(PROFILE_BORDER_HANDOFF);
+    intersectionGridHandOff(&network, now);
+    PROFILE_END(PROFILE_BORDER_HANDOFF);
+
+    simulationTimeMs += SIM_TICK_MS;
+    stats.ticks++;
+    metricsTick(simulationTimeMs);
+    snapshotTick(simulationTimeMs);
+    PROFILE_END(PROFILE_TICK);
+}
+
+void simulationSaveSnapshot(SnapshotBuffer* out) {
+    snapshotPut(out, &simulationTimeMs, sizeof(simulationTimeMs));
+    snapshotPut(out, &stats.ticks, sizeof(stats.ticks));
+    snapshotPut(out, &lastFileCheck, sizeof(lastFileCheck));
+    for (int i = 0; i < network.count; i++) intersectionSaveSnapshot(&network.cells[i], out);
+    inputSaveSnapshot(out);
+    replaySaveSnapshot(out);
+}
+
+// Leaves a half-loaded network on failure; the caller shuts the run down.
+SnapshotStatus simulationLoadSnapshot(SnapshotReader* in) {
+    unsigned long long timeMs, ticks, fileCheck;
+    if (!snapshotGet(in, &timeMs, sizeof(timeMs))
+        || !snapshotGet(in, &ticks, sizeof(ticks))
+        || !snapshotGet(in, &fileCheck, sizeof(fileCheck))) return SNAPSHOT_CORRUPT;
+    for (int i = 0; i < network.count; i++) {
+        if (!intersectionLoadSnapshot(&network.cells[i], in)) return SNAPSHOT_CORRUPT;
+    }
+    if (!inputLoadSnapshot(in)) return SNAPSHOT_CORRUPT;
+    SnapshotStatus status = replayLoadSnapshot(in);
+    if (status != SNAPSHOT_OK) return status;
+
+    simulationTimeMs = timeMs;
+    stats.ticks = ticks;
+    lastFileCheck = fileCheck;
+    metricsRestartAt(simulationTimeMs);
+    return SNAPSHOT_OK;
+}
+
+// Ticks run at multiples of SIM_TICK_MS from zero.
+static unsigned long long firstTickAtOrAfter(unsigned long long timeMs) {
+    if (timeMs > ULLONG_MAX - SIM_TICK_MS) return ULLONG_MAX;
+    return (timeMs + SIM_TICK_MS - 1) / SIM_TICK_MS * SIM_TICK_MS;
+}
+
+// First tick in which the input may put a vehicle on the road. The shared
+// ring and the ingest thread can deliver at any time.
+static unsigned long long nextInputTickMs(void) {
+    unsigned long long due;
+    if (replayIsActive()) due = firstTickAtOrAfter(replayNextArrivalMs());
+    else if (ingestSharedRingActive() || ingestIsRunning()) due = simulationTimeMs;
+    else due = firstTickAtOrAfter(lastFileCheck + FILE_POLL_INTERVAL_MS);
+    return due > simulationTimeMs ? due : simulationTimeMs;
+}
+
+static int networkIsIdle(void) {
+    if (countPendingSpawns() > 0) return 0;
+    for (int i = 0; i < network.count; i++) {
+        if (!intersectionIsIdle(&network.cells[i])) return 0;
+    }
+    return 1;
+}
+
+static void pushLightEvent(int index, unsigned long long endMs) {
+    unsigned long long tick = firstTickAtOrAfter(signalControllerNextIdleSwitchMs(&network.cells[index].signal));
+    if (tick < simulationTimeMs) tick = simulationTimeMs;
+    if (tick < endMs) eventQueuePush(&idleEvents, tick, SIM_EVENT_LIGHT_CHANGE, index);
+}
+
+// Metrics and snapshots run after a step, with the time the step ends at,
+// so the event belongs to the tick before the first such time >= dueMs.
+static void pushAfterStepEvent(SimEventKind kind, unsigned long long dueMs, unsigned long long endMs) {
+    unsigned long long after = firstTickAtOrAfter(dueMs);
+    if (after < simulationTimeMs + SIM_TICK_MS) after = simulationTimeMs + SIM_TICK_MS;
+    if (after != ULLONG_MAX && after - SIM_TICK_MS < endMs) {
+        eventQueuePush(&idleEvents, after - SIM_TICK_MS, kind, 0);
+    }
+}
+
+// Brings every idle tick before toMs up to date at once.
+static void skipIdleTicksUntil(unsigned long long toMs) {
+    unsigned long long from = simulationTimeMs;
+    if (toMs <= from) return;
+    for (int i = 0; i < network.count; i++) intersectionSkipIdleTicks(&network.cells[i], from, toMs);
+    stats.ticks += (toMs - from) / SIM_TICK_MS;
+    stats.idleTicksSkipped += (toMs - from) / SIM_TICK_MS;
+    simulationTimeMs = toMs;
+}
+
+unsigned long long simulationSkipIdle(unsigned long long limitMs) {
+    if (!networkIsIdle()) return 0;
+
+    unsigned long long startMs = simulationTimeMs;
+    unsigned long long endMs = firstTickAtOrAfter(limitMs);
+    unsigned long long inputMs = nextInputTickMs();
+    if (inputMs < endMs) endMs = inputMs;
+    if (endMs <= startMs) return 0;
+
+    // At most one light change per intersection is queued at a time.
+    if (!eventQueueReserve(&idleEvents, network.count + 2)) return 0;
+    eventQueueClear(&idleEvents);
+    for (int i = 0; i < network.count; i++) pushLightEvent(i, endMs);
+    pushAfterStepEvent(SIM_EVENT_METRICS, metricsNextDueMs(), endMs);
+    pushAfterStepEvent(SIM_EVENT_SNAPSHOT, snapshotNextDueMs(), endMs);
+
+    // Each event happens in the tick at e.timeMs: catch up to the end of
+    // that tick first, then apply it.
+    SimEvent e;
+    while (eventQueuePop(&idleEvents, &e)) {
+        skipIdleTicksUntil(e.timeMs + SIM_TICK_MS);
+        switch (e.kind) {
+        case SIM_EVENT_LIGHT_CHANGE:
+            signalControllerSwitchIdle(&network.cells[e.index], e.timeMs);
+            pushLightEvent(e.index, endMs);
+            break;
+        case SIM_EVENT_METRICS:
+            metricsTick(simulationTimeMs);
+            pushAfterStepEvent(SIM_EVENT_METRICS, metricsNextDueMs(), endMs);
+            break;
+        case SIM_EVENT_SNAPSHOT:
+            snapshotTick(simulationTimeMs);
+            pushAfterStepEvent(SIM_EVENT_SNAPSHOT, snapshotNextDueMs(), endMs);
+            break;
+        }
+    }
+    skipIdleTicksUntil(endMs);
+    stats.idleSkips++;
+    return (endMs - startMs) / SIM_TICK_MS;
+}
+
+const SimulationStats* simulationGetStats(void) {
+    stats.vehicleUpdates = 0;
+    stats.vehiclesEntered = 0;
+    stats.vehiclesExited = 0;
+    stats.handOffs = 0;
+    for (int i = 0; i < network.count; i++) {
+        const IntersectionStats* s = &network.cells[i].stats;
+        stats.vehicleUpdates += s->vehicleUpdates;
+        stats.vehiclesEntered += s->vehiclesEntered;
+        stats.vehiclesExited += s->vehiclesExited;
+        stats.handOffs += s->handOffsIn;
+    }
+    return &stats;
+}
+
+int simulationVehicleCount(void) {
+    int total = 0;
+    for (int i = 0; i < network.count; i++) {
+        total += intersectionVehicleCount(&network.cells[i]);
+    }
+    return total;
+}
+
+void simulationSignalStats(SignalPolicyStats* out) {
+    memset(out, 0, sizeof(SignalPolicyStats) * SIGNAL_POLICY_COUNT);
+    for (int i = 0; i < network.count; i++) {
+        for (int p = 0; p < SIGNAL_POLICY_COUNT; p++) {
+            signalStatsAccumulate(&out[p], &network.cells[i].signal.stats[p]);
+        }
+    }
+}
+
+int simulationThreadCount(void) {
+    return workerPoolThreadCount();
+}
+
+static unsigned long long mixDigest(unsigned long long h, unsigned long long value) {
+    h ^= value;
+    return h * 0x100000001B3ULL;
+}
+
+static unsigned long long mixLaneDigest(unsigned long long h, const Lane* L) {
+    h = mixDigest(h, (unsigned long long)L->count);
+    for (int i = 0; i < L->count; i++) {
+        int s = QUEUE_SLOT(L, i);
+        unsigned int xb, yb;
+        memcpy(&xb, &L->x[s], sizeof(xb));
+        memcpy(&yb, &L->y[s], sizeof(yb));
+        h = mixDigest(h, ((unsigned long long)L->info[s].id << 32) ^ xb);
+        h = mixDigest(h, yb);
+    }
+    return h;
+}
+
+// FNV-style fingerprint of every vehicle position, the signal state and the
+// run counters; equal digests mean two runs ended in the same state.
+unsigned long long simulationStateDigest(void) {
+    simulationGetStats();
+
+    unsigned long long h = 0xCBF29CE484222325ULL;
+    for (int n = 0; n < network.count; n++) {
+        const Intersection* in = &network.cells[n];
+        for (int r = 0; r < 4; r++) {
+            h = mixLaneDigest(h, &in->roads[r].L1);
+            h = mixLaneDigest(h, &in->roads[r].L2);
+            h = mixLaneDigest(h, &in->roads[r].L3);
+        }
+        const TransitionPool* pool = &in->transitions;
+        for (int i = pool->head; i >= 0; i = pool->slots[i].next) {
+            const TransitionVehicle* t = &pool->slots[i];
+            unsigned int xb, yb;
+            memcpy(&xb, &t->v.x, sizeof(xb));
+            memcpy(&yb, &t->v.y, sizeof(yb));
+            h = mixDigest(h, ((unsigned long long)t->v.id << 32) ^ xb);
+            h = mixDigest(h, ((unsigned long long)t->targetRoad << 32) ^ yb);
+        }
+        for (int i = 0; i < in->arrivalCount; i++) {
+            h = mixDigest(h, ((unsigned long long)in->arrivals[i].rec.id << 32) ^ (unsigned int)in->arrivals[i].road);
+        }
+        h = mixDigest(h, (unsigned long long)in->currentGreen);
+    }
+    h = mixDigest(h, stats.ticks);
+    h = mixDigest(h, stats.vehicleUpdates);
+    h = mixDigest(h, stats.vehiclesEntered);
+    return h;
+}
@@ -0,0 +1,46 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "types.h"
+#include "signalcontrol.h"
+#include "snapshot.h"
+
+typedef struct {
+    unsigned long long seed;
+    SignalPolicy policy;
+    SignalPriority priority;   // applied at every intersection
+    int rows, cols;
+    int threads;   // 0 = one per core
+    int parallelLanes;   // split each step into per-lane tasks instead of per-intersection ones
+} SimulationConfig;
+
+// Totals over every intersection in the network.
+typedef struct {
+    unsigned long long ticks;
+    unsigned long long vehicleUpdates;
+    unsigned long long vehiclesEntered;
+    unsigned long long vehiclesExited;
+    unsigned long long handOffs;
+    unsigned long long idleTicksSkipped;   // by simulationSkipIdle(), included in ticks
+    unsigned long long idleSkips;
+} SimulationStats;
+
+int simulationInitialize(const SimulationConfig* config);
+void simulationShutdown(void);
+void simulationStep(void);
+// Event-driven time advance: while the network is empty, jumps over every
+// tick before the next input arrival (and before limitMs) by processing
+// only light changes, metrics samples and snapshots from an event queue.
+// The state afterwards is exactly what stepping those ticks would leave.
+// Returns the number of ticks skipped; 0 when a vehicle is anywhere.
+unsigned long long simulationSkipIdle(unsigned long long limitMs);
+const SimulationStats* simulationGetStats(void);
+int simulationVehicleCount(void);
+unsigned long long simulationStateDigest(void);
+void simulationSignalStats(SignalPolicyStats* out);
+int simulationThreadCount(void);
+// Whole network, input read positions and replay progress; see snapshot.h.
+void simulationSaveSnapshot(SnapshotBuffer* out);
+SnapshotStatus simulationLoadSnapshot(SnapshotReader* in);
+
+#endif // SIMULATION_H
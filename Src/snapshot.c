@@ -0,0 +1,258 @@
+#include "snapshot.h"
+#include "globals.h"
+#include "simulation.h"
+#include "fileio.h"
+#include "platform.h"
+#include "vehiclelog.h"
+#include <limits.h>
+
+#define SNAPSHOT_PATH_MAX 512
+
+static SnapshotBuffer buffers[2];
+static char bufferPaths[2][SNAPSHOT_PATH_MAX];
+static int writingBuffer = -1;   // held by the writer thread
+static int pendingBuffer = -1;   // encoded, waiting for the writer
+static int stopRequested = 0;
+static PlatformMutex lock;
+static PlatformCond wake;
+static PlatformThread writerThread;
+static int periodic = 0;
+static const char* pathPrefix = NULL;
+static unsigned long long intervalMs = 0;
+static unsigned long long lastSlot = 0;   // nowMs / intervalMs at the previous tick
+static int haveSlot = 0;
+static unsigned long long written = 0;
+static unsigned long long skipped = 0;
+static unsigned long long longestCaptureNs = 0;
+
+void snapshotPut(SnapshotBuffer* b, const void* data, size_t size) {
+    if (b->failed || size == 0) return;
+    if (b->size + size > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity : 65536;
+        while (capacity < b->size + size) capacity *= 2;
+        unsigned char* grown = realloc(b->data, capacity);
+        if (!grown) {
+            b->failed = 1;
+            return;
+        }
+        b->data = grown;
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+}
+
+int snapshotGet(SnapshotReader* r, void* out, size_t size) {
+    if (!r->failed && size == 0) return 1;
+    if (r->failed || size > r->size - r->offset) {
+        r->failed = 1;
+        return 0;
+    }
+    memcpy(out, r->data + r->offset, size);
+    r->offset += size;
+    return 1;
+}
+
+// Changes whenever a struct copied into the payload changes size.
+static uint32_t measureLayout(void) {
+    const uint32_t sizes[] = {
+        sizeof(Vehicle), sizeof(VehicleInfo), sizeof(TransitionPool), sizeof(SignalState),
+        sizeof(SimRandom), sizeof(IntersectionStats), sizeof(VehicleArrival),
+        sizeof(LaneFileCursor), sizeof(LaneLogCursor), sizeof(PendingSpawnQueue)
+    };
+    return vehicleLogCrc32(sizes, sizeof(sizes));
+}
+
+// Header first, then the payload; the header is filled in once its size is known.
+static int encodeSnapshot(SnapshotBuffer* b) {
+    b->size = 0;
+    b->failed = 0;
+    SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    snapshotPut(b, &h, sizeof(h));
+    simulationSaveSnapshot(b);
+    if (b->failed) return 0;
+
+    memcpy(h.magic, SNAPSHOT_MAGIC, 4);
+    h.version = SNAPSHOT_VERSION;
+    h.headerSize = sizeof(SnapshotHeader);
+    h.layout = measureLayout();
+    h.rows = network.rows;
+    h.cols = network.cols;
+    h.simulationTimeMs = simulationTimeMs;
+    h.payloadSize = b->size - sizeof(h);
+    h.crc = vehicleLogCrc32(b->data + sizeof(h), (size_t)h.payloadSize);
+    memcpy(b->data, &h, sizeof(h));
+    return 1;
+}
+
+// Written next to the target and renamed over it, so a crash mid-write never
+// leaves a truncated snapshot under the real name.
+static int writeSnapshotFile(const char* path, const SnapshotBuffer* b) {
+    char tmp[SNAPSHOT_PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = fwrite(b->data, 1, b->size, f) == b->size;
+    ok = fclose(f) == 0 && ok;
+    if (ok) ok = platformReplaceFile(tmp, path);
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+int snapshotSave(const char* path) {
+    SnapshotBuffer b;
+    memset(&b, 0, sizeof(b));
+    int ok = encodeSnapshot(&b) && writeSnapshotFile(path, &b);
+    free(b.data);
+    return ok;
+}
+
+SnapshotStatus snapshotLoad(const char* path) {
+    PlatformFileMap map;
+    if (!platformMapFile(path, &map)) return SNAPSHOT_UNREADABLE;
+
+    SnapshotStatus status = SNAPSHOT_OK;
+    SnapshotHeader h;
+    if (map.size < sizeof(h)) status = SNAPSHOT_CORRUPT;
+    else {
+        memcpy(&h, map.data, sizeof(h));
+        if (memcmp(h.magic, SNAPSHOT_MAGIC, 4) != 0) status = SNAPSHOT_CORRUPT;
+        else if (h.version != SNAPSHOT_VERSION || h.headerSize != sizeof(h) || h.layout != measureLayout()) {
+            status = SNAPSHOT_INCOMPATIBLE;
+        }
+        else if (h.payloadSize != map.size - sizeof(h)
+            || vehicleLogCrc32((const unsigned char*)map.data + sizeof(h), (size_t)h.payloadSize) != h.crc) {
+            status = SNAPSHOT_CORRUPT;
+        }
+        else if (h.rows != network.rows || h.cols != network.cols) status = SNAPSHOT_GRID_MISMATCH;
+    }
+
+    if (status == SNAPSHOT_OK) {
+        SnapshotReader r;
+        r.data = (const unsigned char*)map.data + sizeof(h);
+        r.size = (size_t)h.payloadSize;
+        r.offset = 0;
+        r.failed = 0;
+        status = simulationLoadSnapshot(&r);
+        if (status == SNAPSHOT_OK && (r.failed || r.offset != r.size)) status = SNAPSHOT_CORRUPT;
+    }
+
+    platformUnmapFile(&map);
+    return status;
+}
+
+const char* snapshotStatusMessage(SnapshotStatus status) {
+    switch (status) {
+    case SNAPSHOT_OK: return "ok";
+    case SNAPSHOT_UNREADABLE: return "cannot be opened";
+    case SNAPSHOT_INCOMPATIBLE: return "was written by an incompatible build";
+    case SNAPSHOT_CORRUPT: return "is damaged";
+    case SNAPSHOT_GRID_MISMATCH: return "is for a different grid size (see --grid)";
+    case SNAPSHOT_INPUT_MISMATCH: return "was taken with a different --replay input";
+    }
+    return "?";
+}
+
+static void runSnapshotWriter(void* arg) {
+    (void)arg;
+    platformMutexLock(&lock);
+    for (;;) {
+        while (pendingBuffer < 0 && !stopRequested) platformCondWait(&wake, &lock);
+        if (pendingBuffer < 0) break;
+
+        writingBuffer = pendingBuffer;
+        pendingBuffer = -1;
+        platformMutexUnlock(&lock);
+
+        int ok = writeSnapshotFile(bufferPaths[writingBuffer], &buffers[writingBuffer]);
+        if (!ok) printf("[ERROR] Cannot write snapshot: %s\n", bufferPaths[writingBuffer]);
+
+        platformMutexLock(&lock);
+        if (ok) written++;
+        writingBuffer = -1;
+    }
+    platformMutexUnlock(&lock);
+}
+
+int snapshotStart(const char* prefix, double intervalSeconds) {
+    if (periodic || !prefix) return 1;
+    pathPrefix = prefix;
+    intervalMs = (unsigned long long)(intervalSeconds * 1000.0);
+    if (intervalMs == 0) intervalMs = SIM_TICK_MS;
+    haveSlot = 0;
+    stopRequested = 0;
+
+    platformMutexInit(&lock);
+    platformCondInit(&wake);
+    if (!platformThreadCreate(&writerThread, runSnapshotWriter, NULL)) {
+        platformCondDestroy(&wake);
+        platformMutexDestroy(&lock);
+        return 0;
+    }
+    periodic = 1;
+    return 1;
+}
+
+// Snapshots fall on multiples of the interval, also after a restore.
+// Encodes into whichever buffer the writer is not holding; a snapshot still
+// waiting there is replaced by the newer one rather than stalling the tick.
+void snapshotTick(unsigned long long nowMs) {
+    if (!periodic) return;
+    unsigned long long slot = nowMs / intervalMs;
+    int due = haveSlot && slot != lastSlot;
+    lastSlot = slot;
+    haveSlot = 1;
+    if (!due) return;
+
+    platformMutexLock(&lock);
+    int target = writingBuffer == 0 ? 1 : 0;
+    if (pendingBuffer == target) {
+        pendingBuffer = -1;
+        skipped++;
+    }
+    platformMutexUnlock(&lock);
+
+    unsigned long long start = platformNowNs();
+    if (!encodeSnapshot(&buffers[target])) {
+        printf("[ERROR] Cannot encode snapshot at %.3f s\n", nowMs / 1000.0);
+        return;
+    }
+    unsigned long long elapsed = platformNowNs() - start;
+    if (elapsed > longestCaptureNs) longestCaptureNs = elapsed;
+    snprintf(bufferPaths[target], SNAPSHOT_PATH_MAX, "%s_%012llu.snap", pathPrefix, nowMs);
+
+    platformMutexLock(&lock);
+    if (pendingBuffer >= 0) skipped++;
+    pendingBuffer = target;
+    platformCondBroadcast(&wake);
+    platformMutexUnlock(&lock);
+}
+
+unsigned long long snapshotNextDueMs(void) {
+    if (!periodic) return ULLONG_MAX;
+    if (!haveSlot) return 0;
+    return (lastSlot + 1) * intervalMs;
+}
+
+// Waits for the last snapshot to be written.
+void snapshotStop(void) {
+    if (!periodic) return;
+    platformMutexLock(&lock);
+    stopRequested = 1;
+    platformCondBroadcast(&wake);
+    platformMutexUnlock(&lock);
+    platformThreadJoin(writerThread);
+    platformCondDestroy(&wake);
+    platformMutexDestroy(&lock);
+    periodic = 0;
+
+    printf("Snapshots: %llu written, %llu replaced before writing, longest capture %.2f ms, largest %.1f KiB\n",
+        written, skipped, longestCaptureNs / 1e6, buffers[0].size > buffers[1].size ?
+        buffers[0].size / 1024.0 : buffers[1].size / 1024.0);
+    for (int i = 0; i < 2; i++) {
+        free(buffers[i].data);
+        memset(&buffers[i], 0, sizeof(buffers[i]));
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary checkpoint of a whole run: SnapshotHeader, then a payload written
+// by simulationSaveSnapshot(). The payload uses native byte order and struct
+// layout, so it is only read back by a build with the same layout, which the
+// header records.
+#define SNAPSHOT_MAGIC "TSNP"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t layout;   // CRC of the struct sizes the payload depends on
+    int32_t rows, cols;
+    uint32_t crc;      // CRC-32 of the payload
+    uint64_t simulationTimeMs;
+    uint64_t payloadSize;
+} SnapshotHeader;
+
+// Growable buffer a snapshot is encoded into; failed sticks after the first
+// allocation failure.
+typedef struct {
+    unsigned char* data;
+    size_t size, capacity;
+    int failed;
+} SnapshotBuffer;
+
+// Reads a payload back; failed sticks once a read runs past the end.
+typedef struct {
+    const unsigned char* data;
+    size_t size, offset;
+    int failed;
+} SnapshotReader;
+
+void snapshotPut(SnapshotBuffer* b, const void* data, size_t size);
+int snapshotGet(SnapshotReader* r, void* out, size_t size);
+
+typedef enum {
+    SNAPSHOT_OK,
+    SNAPSHOT_UNREADABLE,
+    SNAPSHOT_INCOMPATIBLE,   // other format version or struct layout
+    SNAPSHOT_CORRUPT,
+    SNAPSHOT_GRID_MISMATCH,
+    SNAPSHOT_INPUT_MISMATCH  // taken with another replay (or none)
+} SnapshotStatus;
+
+// Both run between ticks on the simulation thread. A load replaces the state
+// of an initialized network of the same size.
+int snapshotSave(const char* path);
+SnapshotStatus snapshotLoad(const char* path);
+const char* snapshotStatusMessage(SnapshotStatus status);
+
+// Periodic snapshots every intervalSeconds of simulated time to
+// <prefix>_<simulated ms>.snap. The tick only encodes into one of two
+// buffers; a background thread writes the other one out.
+int snapshotStart(const char* prefix, double intervalSeconds);
+void snapshotTick(unsigned long long nowMs);
+// Earliest time passed to snapshotTick() at which it does anything.
+unsigned long long snapshotNextDueMs(void);
+void snapshotStop(void);
+
+#endif // SNAPSHOT_H
@@ -1,23 +1,139 @@
 #include "transition.h"
 #include "geometry.h"
-#include "globals.h"
+#include "intersection.h"
+#include "physics.h"
 #include "queue.h"
 #include <math.h>
-#include <SDL.h>
-
-void processIntersectionTransitions() {
-    for (int i = 0; i < transitionCount - 1; i++) {
-        for (int j = i + 1; j < transitionCount; j++) {
-            if (transitions[j].waitingTime > transitions[i].waitingTime) {
-                TransitionVehicle temp = transitions[i];
-                transitions[i] = transitions[j];
-                transitions[j] = temp;
+
+// Grid cells are one conflict radius wide, so every vehicle within the
+// radius sits in the 3x3 block around a point. Positions outside the box
+// are clamped to the border cells.
+static int transitionGridCoord(float v, float origin) {
+    int c = (int)floorf((v - origin) / TRANSITION_CONFLICT_RADIUS);
+    if (c < 0) return 0;
+    if (c >= TRANSITION_GRID_CELLS) return TRANSITION_GRID_CELLS - 1;
+    return c;
+}
+
+static float transitionGridOriginX(void) {
+    return SCREEN_W / 2.0f - TRANSITION_GRID_CELLS * TRANSITION_CONFLICT_RADIUS / 2.0f;
+}
+
+static float transitionGridOriginY(void) {
+    return SCREEN_H / 2.0f - TRANSITION_GRID_CELLS * TRANSITION_CONFLICT_RADIUS / 2.0f;
+}
+
+static void clearTransitionGrid(TransitionPool* pool) {
+    for (int c = 0; c < TRANSITION_GRID_CELLS * TRANSITION_GRID_CELLS; c++) {
+        pool->gridHead[c] = -1;
+    }
+}
+
+static void addToTransitionGrid(TransitionPool* pool, int slot) {
+    int gx = transitionGridCoord(pool->slots[slot].v.x, transitionGridOriginX());
+    int gy = transitionGridCoord(pool->slots[slot].v.y, transitionGridOriginY());
+    int cell = gy * TRANSITION_GRID_CELLS + gx;
+    pool->gridNext[slot] = pool->gridHead[cell];
+    pool->gridHead[cell] = slot;
+}
+
+static int isNearGridVehicle(const TransitionPool* pool, float x, float y) {
+    int gx = transitionGridCoord(x, transitionGridOriginX());
+    int gy = transitionGridCoord(y, transitionGridOriginY());
+
+    for (int cy = gy - 1; cy <= gy + 1; cy++) {
+        if (cy < 0 || cy >= TRANSITION_GRID_CELLS) continue;
+        for (int cx = gx - 1; cx <= gx + 1; cx++) {
+            if (cx < 0 || cx >= TRANSITION_GRID_CELLS) continue;
+            for (int j = pool->gridHead[cy * TRANSITION_GRID_CELLS + cx]; j >= 0; j = pool->gridNext[j]) {
+                float otherDist = calculateDistance(x, y, pool->slots[j].v.x, pool->slots[j].v.y);
+                if (otherDist < TRANSITION_CONFLICT_RADIUS) return 1;
             }
         }
     }
+    return 0;
+}
+
+void transitionPoolInitialize(TransitionPool* pool) {
+    for (int i = 0; i < MAX_TRANSITIONS; i++) {
+        pool->slots[i].generation = 0;
+        pool->slots[i].prev = -1;
+        pool->slots[i].next = i + 1 < MAX_TRANSITIONS ? i + 1 : -1;
+    }
+    pool->head = -1;
+    pool->tail = -1;
+    pool->freeHead = 0;
+    pool->count = 0;
+}
+
+void transitionPoolRemove(TransitionPool* pool, int slot) {
+    TransitionVehicle* tv = &pool->slots[slot];
+
+    if (tv->prev >= 0) pool->slots[tv->prev].next = tv->next;
+    else pool->head = tv->next;
+    if (tv->next >= 0) pool->slots[tv->next].prev = tv->prev;
+    else pool->tail = tv->prev;
+
+    tv->generation = (tv->generation + 1) & 0x7FFF;
+    tv->prev = -1;
+    tv->next = pool->freeHead;
+    pool->freeHead = slot;
+    pool->count--;
+}
 
-    for (int i = 0; i < transitionCount; i++) {
-        TransitionVehicle* tv = &transitions[i];
+TransitionHandle transitionPoolHandle(const TransitionPool* pool, int slot) {
+    return (pool->slots[slot].generation << 16) | slot;
+}
+
+TransitionVehicle* transitionPoolResolve(TransitionPool* pool, TransitionHandle handle) {
+    int slot = handle & 0xFFFF;
+    if (handle < 0 || slot >= MAX_TRANSITIONS) return NULL;
+    if (pool->slots[slot].generation != (handle >> 16)) return NULL;
+    return &pool->slots[slot];
+}
+
+// The live list is kept ordered by waitingTime, longest first. Every entry
+// ages by one per frame, so the order only changes on insert.
+TransitionHandle insertVehicleIntoTransition(TransitionPool* pool, Vehicle v, int targetRoad) {
+    int slot = pool->freeHead;
+    if (slot < 0) return -1;
+    pool->freeHead = pool->slots[slot].next;
+
+    TransitionVehicle* tv = &pool->slots[slot];
+    v.isStopped = 0;
+    tv->v = v;
+    tv->targetRoad = targetRoad;
+    tv->waitingTime = 0;
+
+    int after = pool->tail;
+    while (after >= 0 && pool->slots[after].waitingTime < tv->waitingTime) {
+        after = pool->slots[after].prev;
+    }
+
+    tv->prev = after;
+    tv->next = after >= 0 ? pool->slots[after].next : pool->head;
+    if (tv->next >= 0) pool->slots[tv->next].prev = slot;
+    else pool->tail = slot;
+    if (after >= 0) pool->slots[after].next = slot;
+    else pool->head = slot;
+
+    pool->count++;
+    return transitionPoolHandle(pool, slot);
+}
+
+void processIntersectionTransitions(Intersection* in, unsigned long long nowMs) {
+    TransitionPool* pool = &in->transitions;
+    RoadData* roads = in->roads;
+
+    // Only vehicles that have waited at least as long can hold a vehicle
+    // back, and those are exactly the ones already processed this frame,
+    // so the grid is filled as the loop goes.
+    clearTransitionGrid(pool);
+
+    int next;
+    for (int i = pool->head; i >= 0; i = next) {
+        TransitionVehicle* tv = &pool->slots[i];
+        next = tv->next;
         tv->waitingTime++;
         tv->v.isStopped = 0;
 
@@ -35,41 +151,23 @@ void processIntersectionTransitions() {
             tv->v.fromRoad = tv->targetRoad;
 
             if (!detectCollisionInLane(&roads[tv->targetRoad].L3, tx, ty, -1)) {
+                metricsRecordCrossed(&in->metrics, &tv->v, nowMs);
                 queueInsert(&roads[tv->targetRoad].L3, tv->v);
-
-                for (int j = i; j < transitionCount - 1; j++) {
-                    transitions[j] = transitions[j + 1];
-                }
-                transitionCount--;
-                i--;
+                transitionPoolRemove(pool, i);
+                continue;
             }
             else {
                 tv->v.isStopped = 1;
                 if (tv->waitingTime > 50) {
+                    metricsRecordCrossed(&in->metrics, &tv->v, nowMs);
                     queueInsert(&roads[tv->targetRoad].L3, tv->v);
-
-                    for (int j = i; j < transitionCount - 1; j++) {
-                        transitions[j] = transitions[j + 1];
-                    }
-                    transitionCount--;
-                    i--;
+                    transitionPoolRemove(pool, i);
+                    continue;
                 }
             }
         }
         else {
-            int canMove = 1;
-
-            for (int j = 0; j < transitionCount; j++) {
-                if (i == j) continue;
-                float otherDist = calculateDistance(tv->v.x, tv->v.y,
-                    transitions[j].v.x, transitions[j].v.y);
-                if (otherDist < MIN_FRONT_SPACING * 1.5f) {
-                    if (transitions[j].waitingTime >= tv->waitingTime) {
-                        canMove = 0;
-                        break;
-                    }
-                }
-            }
+            int canMove = !isNearGridVehicle(pool, tv->v.x, tv->v.y);
 
             if (canMove) {
                 float newx = tv->v.x + speed * dx / dist;
@@ -86,23 +184,23 @@ void processIntersectionTransitions() {
                 tv->v.isStopped = 1;
             }
         }
+
+        addToTransitionGrid(pool, i);
     }
 }
 
-void removeStuckTransitionVehicles() {
-    static Uint32 lastCleanup = 0;
-    Uint32 now = SDL_GetTicks();
+void removeStuckTransitionVehicles(Intersection* in, unsigned long long nowMs) {
+    TransitionPool* pool = &in->transitions;
 
-    if (now - lastCleanup >= 5000) {
-        for (int i = 0; i < transitionCount; i++) {
-            if (transitions[i].waitingTime > 150) {
-                for (int j = i; j < transitionCount - 1; j++) {
-                    transitions[j] = transitions[j + 1];
-                }
-                transitionCount--;
-                i--;
+    if (nowMs - in->lastStuckCleanupMs >= STUCK_CLEANUP_INTERVAL_MS) {
+        int next;
+        for (int i = pool->head; i >= 0; i = next) {
+            next = pool->slots[i].next;
+            if (pool->slots[i].waitingTime > 150) {
+                transitionPoolRemove(pool, i);
+                metricsRecordDrop(&in->metrics, METRICS_DROP_STUCK);
             }
         }
-        lastCleanup = now;
+        in->lastStuckCleanupMs = nowMs;
     }
 }
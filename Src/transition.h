@@ -3,7 +3,12 @@
 
 #include "types.h"
 
-void processIntersectionTransitions(void);
-void removeStuckTransitionVehicles(void);
+void transitionPoolInitialize(TransitionPool* pool);
+void transitionPoolRemove(TransitionPool* pool, int slot);
+TransitionHandle transitionPoolHandle(const TransitionPool* pool, int slot);
+TransitionVehicle* transitionPoolResolve(TransitionPool* pool, TransitionHandle handle);
+TransitionHandle insertVehicleIntoTransition(TransitionPool* pool, Vehicle v, int targetRoad);
+void processIntersectionTransitions(Intersection* in, unsigned long long nowMs);
+void removeStuckTransitionVehicles(Intersection* in, unsigned long long nowMs);
 
 #endif // TRANSITION_H
@@ -3,23 +3,81 @@
 
 #include "config.h"
 
+#define VEHICLE_TIME_UNSET 0xFFFFFFFFu
+
+// Lifecycle timestamps in simulated milliseconds, read by the metrics
+// pipeline (metrics.h). The approach fields restart at every intersection.
+typedef struct {
+    unsigned int spawnMs;       // entered the network
+    unsigned int laneMs;        // joined its current lane
+    unsigned int firstStopMs;   // first stop on the current approach, or VEHICLE_TIME_UNSET
+    unsigned int entryMs;       // entered the current intersection, or VEHICLE_TIME_UNSET
+} VehicleTimes;
+
 typedef struct {
     int id;
     float x, y;
     int fromRoad;
     int isStopped;
     char name[NAME_MAX];
+    VehicleTimes times;
 } Vehicle;
 
+typedef struct {
+    int id;
+    int lane;
+    char name[NAME_MAX];
+} VehicleRecord;
+
 typedef struct {
     Vehicle v;
     int targetRoad;
     int waitingTime;
+    int generation;
+    int prev, next;
 } TransitionVehicle;
 
+// Stable reference to a pool slot: (generation << 16) | slot. A handle to
+// a slot that has since been freed and reused no longer resolves.
+typedef int TransitionHandle;
+
+// Uniform grid over the intersection box with cells one conflict radius
+// wide, rebuilt every tick by processIntersectionTransitions().
+#define TRANSITION_GRID_CELLS 8
+
+// Fixed pool of transition slots. Live slots form a list ordered by
+// waitingTime (longest first); free slots are chained through next.
 typedef struct {
-    Vehicle data[MAX_QUEUE];
-    int front, rear, count;
+    TransitionVehicle slots[MAX_TRANSITIONS];
+    int head, tail;
+    int freeHead;
+    int count;
+    int gridHead[TRANSITION_GRID_CELLS * TRANSITION_GRID_CELLS];
+    int gridNext[MAX_TRANSITIONS];
+} TransitionPool;
+
+typedef struct {
+    int id;
+    int fromRoad;
+    char name[NAME_MAX];
+    VehicleTimes times;
+} VehicleInfo;
+
+// Power-of-two ring stored as parallel arrays: the per-tick physics only
+// touches x, y and isStopped; ids and names live in the cold info table.
+// waitMs is how long a vehicle has spent stopped, for the signal controller.
+// Vehicles taken out mid-lane are flagged in isRemoved and squeezed out by
+// queueCompact() once per tick.
+typedef struct {
+    float* x;
+    float* y;
+    unsigned char* isStopped;
+    unsigned char* isRemoved;
+    unsigned int* waitMs;
+    VehicleInfo* info;
+    int front, count;
+    int capacity, mask;
+    int removedCount;
 } Lane;
 
 typedef struct {
@@ -28,4 +86,12 @@ typedef struct {
     Lane L3;
 } RoadData;
 
+// Growable list of whole vehicles, e.g. those leaving an intersection.
+typedef struct {
+    Vehicle* items;
+    int count, capacity;
+} VehicleBuffer;
+
+typedef struct Intersection Intersection;
+
 #endif // TYPES_H
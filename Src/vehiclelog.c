@@ -0,0 +1,101 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "vehiclelog.h"
+#include <string.h>
+
+static uint32_t crcTable[256];
+static int crcTableReady = 0;
+
+static void buildCrcTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[i] = c;
+    }
+    crcTableReady = 1;
+}
+
+uint32_t vehicleLogCrc32(const void* data, size_t length) {
+    if (!crcTableReady) buildCrcTable();
+
+    const unsigned char* p = data;
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        c = crcTable[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+int vehicleLogCreate(VehicleLogWriter* w, const char* path, uint32_t sessionId) {
+    w->f = fopen(path, "wb");
+    w->sessionId = sessionId;
+    if (!w->f) return 0;
+
+    VehicleLogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, VEHICLE_LOG_MAGIC, 4);
+    h.version = VEHICLE_LOG_VERSION;
+    h.recordSize = sizeof(VehicleLogRecord);
+    h.sessionId = sessionId;
+
+    if (fwrite(&h, sizeof(h), 1, w->f) != 1 || fflush(w->f) != 0) {
+        vehicleLogClose(w);
+        return 0;
+    }
+    return 1;
+}
+
+int vehicleLogAppendBatch(VehicleLogWriter* w, const VehicleLogRecord* records, int count) {
+    if (!w->f || count <= 0 || count > VEHICLE_LOG_MAX_BATCH) return 0;
+
+    VehicleLogBatchHeader b;
+    b.magic = VEHICLE_LOG_BATCH_MAGIC;
+    b.count = (uint32_t)count;
+    b.crc = vehicleLogCrc32(records, sizeof(VehicleLogRecord) * (size_t)count);
+
+    if (fwrite(&b, sizeof(b), 1, w->f) != 1) return 0;
+    if (fwrite(records, sizeof(VehicleLogRecord), (size_t)count, w->f) != (size_t)count) return 0;
+    return fflush(w->f) == 0;
+}
+
+void vehicleLogClose(VehicleLogWriter* w) {
+    if (w->f) fclose(w->f);
+    w->f = NULL;
+}
+
+VehicleLogStatus vehicleLogReadHeader(const void* data, size_t size, VehicleLogHeader* out) {
+    if (size < sizeof(VehicleLogHeader)) return VEHICLE_LOG_INCOMPLETE;
+
+    memcpy(out, data, sizeof(VehicleLogHeader));
+    if (memcmp(out->magic, VEHICLE_LOG_MAGIC, 4) != 0) return VEHICLE_LOG_CORRUPT;
+    if (out->version != VEHICLE_LOG_VERSION) return VEHICLE_LOG_CORRUPT;
+    if (out->recordSize != sizeof(VehicleLogRecord)) return VEHICLE_LOG_CORRUPT;
+    return VEHICLE_LOG_OK;
+}
+
+// On OK, *records points into data and *offset moves past the batch. A CRC
+// mismatch also moves *offset past the batch so the caller can skip it; a
+// bad batch header leaves *offset alone since the stream cannot be resynced.
+VehicleLogStatus vehicleLogNextBatch(const void* data, size_t size, size_t* offset,
+    const VehicleLogRecord** records, int* count) {
+    const unsigned char* base = data;
+    if (*offset > size || size - *offset < sizeof(VehicleLogBatchHeader)) return VEHICLE_LOG_INCOMPLETE;
+
+    VehicleLogBatchHeader b;
+    memcpy(&b, base + *offset, sizeof(b));
+    if (b.magic != VEHICLE_LOG_BATCH_MAGIC || b.count == 0 || b.count > VEHICLE_LOG_MAX_BATCH) {
+        return VEHICLE_LOG_CORRUPT;
+    }
+
+    size_t bytes = sizeof(VehicleLogRecord) * (size_t)b.count;
+    size_t start = *offset + sizeof(VehicleLogBatchHeader);
+    if (size - start < bytes) return VEHICLE_LOG_INCOMPLETE;
+
+    *offset = start + bytes;
+    if (vehicleLogCrc32(base + start, bytes) != b.crc) return VEHICLE_LOG_CORRUPT;
+
+    *records = (const VehicleLogRecord*)(base + start);
+    *count = (int)b.count;
+    return VEHICLE_LOG_OK;
+}
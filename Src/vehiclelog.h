@@ -0,0 +1,65 @@
+#ifndef VEHICLELOG_H
+#define VEHICLELOG_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Append-only binary vehicle log shared by the generator and the simulator.
+//
+//   file   = VehicleLogHeader, then batches
+//   batch  = VehicleLogBatchHeader, then count fixed-size VehicleLogRecords
+//
+// All fields are in host byte order (little-endian on every supported
+// target) and 4-byte aligned, so a batch read into an aligned buffer can be
+// used in place. The CRC covers the records of one batch; a writer appends
+// whole batches, so a batch whose bytes are not all present yet is simply
+// read on a later poll.
+#define VEHICLE_LOG_MAGIC "TVLG"
+#define VEHICLE_LOG_BATCH_MAGIC 0x54414256u // "VBAT"
+#define VEHICLE_LOG_VERSION 1
+#define VEHICLE_LOG_NAME_MAX 16
+#define VEHICLE_LOG_MAX_BATCH 4096
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t sessionId;   // random per file, so a recreated log is noticed
+    uint32_t reserved;
+} VehicleLogHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t crc;
+} VehicleLogBatchHeader;
+
+typedef struct {
+    int32_t id;
+    int32_t lane;
+    char name[VEHICLE_LOG_NAME_MAX];
+} VehicleLogRecord;
+
+typedef enum {
+    VEHICLE_LOG_OK,
+    VEHICLE_LOG_INCOMPLETE,
+    VEHICLE_LOG_CORRUPT
+} VehicleLogStatus;
+
+typedef struct {
+    FILE* f;
+    uint32_t sessionId;
+} VehicleLogWriter;
+
+uint32_t vehicleLogCrc32(const void* data, size_t length);
+
+int vehicleLogCreate(VehicleLogWriter* w, const char* path, uint32_t sessionId);
+int vehicleLogAppendBatch(VehicleLogWriter* w, const VehicleLogRecord* records, int count);
+void vehicleLogClose(VehicleLogWriter* w);
+
+VehicleLogStatus vehicleLogReadHeader(const void* data, size_t size, VehicleLogHeader* out);
+VehicleLogStatus vehicleLogNextBatch(const void* data, size_t size, size_t* offset,
+    const VehicleLogRecord** records, int* count);
+
+#endif // VEHICLELOG_H
@@ -0,0 +1,283 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "vehiclering.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define VEHICLE_RING_MASK (VEHICLE_RING_CAPACITY - 1)
+
+// Both processes see these words, so they are full barriers on every access.
+#ifdef _WIN32
+static uint32_t ringLoad(const volatile uint32_t* p) {
+    return (uint32_t)InterlockedCompareExchange((volatile LONG*)p, 0, 0);
+}
+static void ringStore(volatile uint32_t* p, uint32_t value) {
+    InterlockedExchange((volatile LONG*)p, (LONG)value);
+}
+static void ringIncrement(volatile uint32_t* p) {
+    InterlockedIncrement((volatile LONG*)p);
+}
+#else
+static uint32_t ringLoad(const volatile uint32_t* p) {
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static void ringStore(volatile uint32_t* p, uint32_t value) {
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+static void ringIncrement(volatile uint32_t* p) {
+    __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+#endif
+
+// Sleeps while *word still equals expected, for at most timeoutMs.
+static void waitOnWord(VehicleRing* r, volatile uint32_t* word, uint32_t expected, int timeoutMs) {
+#ifdef _WIN32
+    (void)word;
+    (void)expected;
+    WaitForSingleObject(r->spaceEvent, (DWORD)timeoutMs);
+#elif defined(__linux__)
+    (void)r;
+    struct timespec ts = { timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, &ts, NULL, 0);
+#else
+    // No cross-process futex here: nap briefly and let the caller look again.
+    (void)r;
+    (void)word;
+    (void)expected;
+    usleep((timeoutMs < 1 ? timeoutMs : 1) * 1000);
+#endif
+}
+
+static void wakeWord(VehicleRing* r, volatile uint32_t* word) {
+#ifdef _WIN32
+    (void)word;
+    SetEvent(r->spaceEvent);
+#elif defined(__linux__)
+    (void)r;
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)r;
+    (void)word;
+#endif
+}
+
+static void initializeShared(VehicleRingShared* s) {
+    ringStore(&s->closed, 1);
+    for (int road = 0; road < 4; road++) {
+        s->roads[road].head = 0;
+        s->roads[road].tail = 0;
+    }
+    s->version = VEHICLE_RING_VERSION;
+    s->recordSize = sizeof(VehicleLogRecord);
+    s->capacity = VEHICLE_RING_CAPACITY;
+    s->producerWaiting = 0;
+    ringStore(&s->closed, 0);
+    ringStore(&s->magic, VEHICLE_RING_MAGIC);
+}
+
+static int sharedIsUsable(const VehicleRingShared* s) {
+    return ringLoad(&s->magic) == VEHICLE_RING_MAGIC && s->version == VEHICLE_RING_VERSION
+        && s->recordSize == sizeof(VehicleLogRecord) && s->capacity == VEHICLE_RING_CAPACITY
+        && !ringLoad(&s->closed);
+}
+
+#ifdef _WIN32
+static void eventName(const char* name, char* out, size_t size) {
+    snprintf(out, size, "%s.space", name);
+}
+
+static void releaseHandles(VehicleRing* r) {
+    if (r->shared) UnmapViewOfFile(r->shared);
+    if (r->mapping) CloseHandle(r->mapping);
+    if (r->spaceEvent) CloseHandle(r->spaceEvent);
+    r->shared = NULL;
+    r->mapping = NULL;
+    r->spaceEvent = NULL;
+}
+
+// A mapping still held by a generator keeps its name, so it is reset in place.
+int vehicleRingCreate(VehicleRing* r, const char* name) {
+    memset(r, 0, sizeof(*r));
+    char event[VEHICLE_RING_NAME_MAX + 8];
+    eventName(name, event, sizeof(event));
+
+    r->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(VehicleRingShared), name);
+    if (r->mapping) r->shared = MapViewOfFile(r->mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VehicleRingShared));
+    if (r->shared) r->spaceEvent = CreateEventA(NULL, FALSE, FALSE, event);
+    if (!r->spaceEvent) {
+        releaseHandles(r);
+        return 0;
+    }
+
+    initializeShared(r->shared);
+    r->owner = 1;
+    strncpy(r->name, name, VEHICLE_RING_NAME_MAX - 1);
+    return 1;
+}
+
+int vehicleRingOpen(VehicleRing* r, const char* name) {
+    memset(r, 0, sizeof(*r));
+    char event[VEHICLE_RING_NAME_MAX + 8];
+    eventName(name, event, sizeof(event));
+
+    r->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (r->mapping) r->shared = MapViewOfFile(r->mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VehicleRingShared));
+    if (r->shared) r->spaceEvent = OpenEventA(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, event);
+    if (!r->spaceEvent || !sharedIsUsable(r->shared)) {
+        releaseHandles(r);
+        return 0;
+    }
+    strncpy(r->name, name, VEHICLE_RING_NAME_MAX - 1);
+    return 1;
+}
+#else
+static VehicleRingShared* mapShared(int fd) {
+    void* p = mmap(NULL, sizeof(VehicleRingShared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+// Tells a generator still attached to an older ring of this name to reopen.
+static void closeStaleRing(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return;
+
+    struct stat st;
+    VehicleRingShared* s = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(VehicleRingShared)) s = mapShared(fd);
+    else close(fd);
+    if (s) {
+        ringStore(&s->closed, 1);
+        ringIncrement(&s->spaceSeq);
+        wakeWord(NULL, &s->spaceSeq);
+        munmap(s, sizeof(VehicleRingShared));
+    }
+    shm_unlink(name);
+}
+
+int vehicleRingCreate(VehicleRing* r, const char* name) {
+    memset(r, 0, sizeof(*r));
+    closeStaleRing(name);
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return 0;
+    if (ftruncate(fd, sizeof(VehicleRingShared)) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return 0;
+    }
+    r->shared = mapShared(fd);
+    if (!r->shared) {
+        shm_unlink(name);
+        return 0;
+    }
+
+    initializeShared(r->shared);
+    r->owner = 1;
+    strncpy(r->name, name, VEHICLE_RING_NAME_MAX - 1);
+    return 1;
+}
+
+int vehicleRingOpen(VehicleRing* r, const char* name) {
+    memset(r, 0, sizeof(*r));
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(VehicleRingShared)) {
+        close(fd);
+        return 0;
+    }
+    r->shared = mapShared(fd);
+    if (r->shared && !sharedIsUsable(r->shared)) {
+        munmap(r->shared, sizeof(VehicleRingShared));
+        r->shared = NULL;
+    }
+    if (!r->shared) return 0;
+    strncpy(r->name, name, VEHICLE_RING_NAME_MAX - 1);
+    return 1;
+}
+#endif
+
+void vehicleRingClose(VehicleRing* r) {
+    VehicleRingShared* s = r->shared;
+    if (!s) return;
+
+    if (r->owner) {
+        ringStore(&s->closed, 1);
+        ringIncrement(&s->spaceSeq);
+        wakeWord(r, &s->spaceSeq);
+    }
+#ifdef _WIN32
+    releaseHandles(r);
+#else
+    munmap(s, sizeof(VehicleRingShared));
+    if (r->owner) shm_unlink(r->name);
+#endif
+    r->shared = NULL;
+    r->owner = 0;
+}
+
+int vehicleRingIsClosed(const VehicleRing* r) {
+    return !r->shared || ringLoad(&r->shared->closed);
+}
+
+int vehicleRingFree(const VehicleRing* r, int road) {
+    const VehicleRingRoad* q = &r->shared->roads[road];
+    return VEHICLE_RING_CAPACITY - (int)(q->tail - ringLoad(&q->head));
+}
+
+int vehicleRingPublish(VehicleRing* r, int road, const VehicleLogRecord* records, int count) {
+    VehicleRingRoad* q = &r->shared->roads[road];
+    int room = vehicleRingFree(r, road);
+    if (count > room) count = room;
+
+    uint32_t tail = q->tail;
+    for (int i = 0; i < count; i++) {
+        q->records[(tail + (uint32_t)i) & VEHICLE_RING_MASK] = records[i];
+    }
+    ringStore(&q->tail, tail + (uint32_t)count);
+    return count;
+}
+
+uint32_t vehicleRingSpaceSequence(const VehicleRing* r) {
+    return ringLoad(&r->shared->spaceSeq);
+}
+
+int vehicleRingWaitForSpace(VehicleRing* r, uint32_t sequence, int timeoutMs) {
+    VehicleRingShared* s = r->shared;
+    ringStore(&s->producerWaiting, 1);
+    if (ringLoad(&s->spaceSeq) == sequence && !ringLoad(&s->closed)) {
+        waitOnWord(r, &s->spaceSeq, sequence, timeoutMs);
+    }
+    ringStore(&s->producerWaiting, 0);
+    return ringLoad(&s->spaceSeq) != sequence;
+}
+
+const VehicleLogRecord* vehicleRingPeek(const VehicleRing* r, int road) {
+    const VehicleRingRoad* q = &r->shared->roads[road];
+    uint32_t head = q->head;
+    if (head == ringLoad(&q->tail)) return NULL;
+    return &q->records[head & VEHICLE_RING_MASK];
+}
+
+void vehicleRingRelease(VehicleRing* r, int road) {
+    VehicleRingShared* s = r->shared;
+    VehicleRingRoad* q = &s->roads[road];
+    ringStore(&q->head, q->head + 1);
+    ringIncrement(&s->spaceSeq);
+    if (ringLoad(&s->producerWaiting)) wakeWord(r, &s->spaceSeq);
+}
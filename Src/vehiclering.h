@@ -0,0 +1,76 @@
+#ifndef VEHICLERING_H
+#define VEHICLERING_H
+
+#include <stdint.h>
+#include "vehiclelog.h"
+
+// Shared-memory transport between the generator and the simulator: one
+// single-producer/single-consumer ring of VehicleLogRecords per road in a
+// named mapping. The simulator creates and owns the mapping; the generator
+// opens it and waits on a futex (a named event on Windows) while every road
+// it wants to write is full. Indices run freely and are masked on access.
+#define VEHICLE_RING_MAGIC 0x474E5256u // "VRNG"
+#define VEHICLE_RING_VERSION 1
+#define VEHICLE_RING_CAPACITY 1024   // records per road, a power of two
+#ifdef _WIN32
+#define VEHICLE_RING_DEFAULT_NAME "Local\\TrafficVehicleRing"
+#else
+#define VEHICLE_RING_DEFAULT_NAME "/traffic-vehicle-ring"
+#endif
+#define VEHICLE_RING_NAME_MAX 64
+
+// head and tail sit on their own cache lines so the two processes do not
+// share one while they run.
+typedef struct {
+    volatile uint32_t head;   // written by the consumer only
+    uint32_t pad0[15];
+    volatile uint32_t tail;   // written by the producer only
+    uint32_t pad1[15];
+    VehicleLogRecord records[VEHICLE_RING_CAPACITY];
+} VehicleRingRoad;
+
+typedef struct {
+    volatile uint32_t magic;   // stored last, once the rest is set up
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;
+    volatile uint32_t closed;            // the owner has gone; reopen to continue
+    volatile uint32_t spaceSeq;          // bumped whenever the consumer frees a slot
+    volatile uint32_t producerWaiting;
+    uint32_t reserved[10];
+    VehicleRingRoad roads[4];
+} VehicleRingShared;
+
+typedef struct {
+    VehicleRingShared* shared;
+    int owner;
+    char name[VEHICLE_RING_NAME_MAX];
+#ifdef _WIN32
+    void* mapping;
+    void* spaceEvent;
+#endif
+} VehicleRing;
+
+// Owner side (simulator). Any stale mapping of the same name is replaced.
+int vehicleRingCreate(VehicleRing* r, const char* name);
+// Returns 0 until an owner has created the ring.
+int vehicleRingOpen(VehicleRing* r, const char* name);
+// The owner marks the ring closed and removes the name.
+void vehicleRingClose(VehicleRing* r);
+int vehicleRingIsClosed(const VehicleRing* r);
+
+// Producer side. Publish writes at most the free space and returns how many
+// records it took.
+int vehicleRingFree(const VehicleRing* r, int road);
+int vehicleRingPublish(VehicleRing* r, int road, const VehicleLogRecord* records, int count);
+// Read the sequence before deciding to wait, so a slot freed in between
+// ends the wait at once. Returns 0 on timeout.
+uint32_t vehicleRingSpaceSequence(const VehicleRing* r);
+int vehicleRingWaitForSpace(VehicleRing* r, uint32_t sequence, int timeoutMs);
+
+// Consumer side. Peek returns the oldest record in place, or NULL; Release
+// frees it and wakes a waiting producer.
+const VehicleLogRecord* vehicleRingPeek(const VehicleRing* r, int road);
+void vehicleRingRelease(VehicleRing* r, int road);
+
+#endif // VEHICLERING_H
@@ -0,0 +1,158 @@
+#include "workerpool.h"
+#include "platform.h"
+
+#define WORKER_POOL_MAX_THREADS 64
+
+static PlatformThread threads[WORKER_POOL_MAX_THREADS];
+static int threadCount = 1;   // including the caller
+
+static PlatformMutex lock;
+static PlatformCond workReady;
+static PlatformCond workDone;
+static unsigned long long generation = 0;
+static int pending = 0;
+static int stopping = 0;
+
+static WorkerTask currentTask = NULL;
+static void* currentCtx = NULL;
+static int currentItems = 0;
+static int currentStealing = 0;
+
+// Claim cursor for each share in a stealing run. Owner and thieves both
+// take items with an atomic add, so every item is handed out exactly once.
+typedef struct {
+    PlatformAtomicInt next;
+    int end;
+    char pad[64 - sizeof(PlatformAtomicInt) - sizeof(int)];
+} StealQueue;
+
+static StealQueue queues[WORKER_POOL_MAX_THREADS];
+
+// Contiguous share k of n items, so every run splits the range the same way.
+static int shareBegin(int k) {
+    return (int)((long long)currentItems * k / threadCount);
+}
+
+static int claimFrom(StealQueue* q) {
+    if (platformAtomicLoad(&q->next) >= q->end) return -1;
+    int item = (int)platformAtomicAdd(&q->next, 1) - 1;
+    return item < q->end ? item : -1;
+}
+
+static void runStealing(int k) {
+    int item;
+    while ((item = claimFrom(&queues[k])) >= 0) currentTask(currentCtx, item, item + 1);
+
+    for (int step = 1; step < threadCount; step++) {
+        StealQueue* victim = &queues[(k + step) % threadCount];
+        while ((item = claimFrom(victim)) >= 0) currentTask(currentCtx, item, item + 1);
+    }
+}
+
+static void runShare(int k) {
+    if (currentStealing) {
+        runStealing(k);
+        return;
+    }
+    int begin = shareBegin(k);
+    int end = shareBegin(k + 1);
+    if (begin < end) currentTask(currentCtx, begin, end);
+}
+
+static void workerMain(void* arg) {
+    int k = (int)(size_t)arg;
+    unsigned long long seen = 0;
+
+    for (;;) {
+        platformMutexLock(&lock);
+        while (generation == seen && !stopping) platformCondWait(&workReady, &lock);
+        if (stopping) {
+            platformMutexUnlock(&lock);
+            return;
+        }
+        seen = generation;
+        platformMutexUnlock(&lock);
+
+        runShare(k);
+
+        platformMutexLock(&lock);
+        if (--pending == 0) platformCondBroadcast(&workDone);
+        platformMutexUnlock(&lock);
+    }
+}
+
+int workerPoolStart(int count) {
+    if (count < 1) count = 1;
+    if (count > WORKER_POOL_MAX_THREADS) count = WORKER_POOL_MAX_THREADS;
+
+    platformMutexInit(&lock);
+    platformCondInit(&workReady);
+    platformCondInit(&workDone);
+    stopping = 0;
+    generation = 0;
+
+    threadCount = 1;
+    for (int k = 1; k < count; k++) {
+        if (!platformThreadCreate(&threads[k], workerMain, (void*)(size_t)k)) break;
+        threadCount++;
+    }
+    return threadCount;
+}
+
+void workerPoolStop(void) {
+    platformMutexLock(&lock);
+    stopping = 1;
+    platformCondBroadcast(&workReady);
+    platformMutexUnlock(&lock);
+
+    for (int k = 1; k < threadCount; k++) platformThreadJoin(threads[k]);
+    threadCount = 1;
+
+    platformCondDestroy(&workDone);
+    platformCondDestroy(&workReady);
+    platformMutexDestroy(&lock);
+}
+
+int workerPoolThreadCount(void) {
+    return threadCount;
+}
+
+static void runOnAllThreads(WorkerTask task, void* ctx, int itemCount, int stealing) {
+    platformMutexLock(&lock);
+    currentTask = task;
+    currentCtx = ctx;
+    currentItems = itemCount;
+    currentStealing = stealing;
+    if (stealing) {
+        for (int k = 0; k < threadCount; k++) {
+            platformAtomicStore(&queues[k].next, shareBegin(k));
+            queues[k].end = shareBegin(k + 1);
+        }
+    }
+    pending = threadCount - 1;
+    generation++;
+    platformCondBroadcast(&workReady);
+    platformMutexUnlock(&lock);
+
+    runShare(0);
+
+    platformMutexLock(&lock);
+    while (pending > 0) platformCondWait(&workDone, &lock);
+    platformMutexUnlock(&lock);
+}
+
+void workerPoolRun(WorkerTask task, void* ctx, int itemCount) {
+    if (threadCount == 1 || itemCount <= 1) {
+        task(ctx, 0, itemCount);
+        return;
+    }
+    runOnAllThreads(task, ctx, itemCount, 0);
+}
+
+void workerPoolRunStealing(WorkerTask task, void* ctx, int itemCount) {
+    if (threadCount == 1 || itemCount <= 1) {
+        for (int i = 0; i < itemCount; i++) task(ctx, i, i + 1);
+        return;
+    }
+    runOnAllThreads(task, ctx, itemCount, 1);
+}
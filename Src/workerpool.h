@@ -0,0 +1,20 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+// Fixed set of threads that split a range of items between them. The
+// calling thread takes the first share and each run returns once every
+// item is done, so each call is a full barrier.
+typedef void (*WorkerTask)(void* ctx, int begin, int end);
+
+int workerPoolStart(int threads);
+void workerPoolStop(void);
+int workerPoolThreadCount(void);
+
+// One contiguous share per thread, for items of similar cost.
+void workerPoolRun(WorkerTask task, void* ctx, int itemCount);
+
+// Items of uneven cost: each thread starts on its own share one item at a
+// time, then steals single items from the other shares once it runs dry.
+void workerPoolRunStealing(WorkerTask task, void* ctx, int itemCount);
+
+#endif // WORKERPOOL_H
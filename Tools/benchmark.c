@@ -0,0 +1,423 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../Src/config.h"
+#include "../Src/types.h"
+#include "../Src/globals.h"
+#include "../Src/queue.h"
+#include "../Src/geometry.h"
+#include "../Src/physics.h"
+#include "../Src/transition.h"
+#include "../Src/fileio.h"
+#include "../Src/simulation.h"
+#include "../Src/lanekernel.h"
+#include "../Src/random.h"
+#include "../Src/platform.h"
+
+// Micro and macro benchmarks for the simulation core, written as JSON:
+//   benchmark [--out results.json] [--label name] [--min-time s] [--duration s] [--seed n]
+// Micro cases repeat until --min-time seconds of measured work (default 0.5)
+// and report ns per operation. Macro scenarios drive one intersection for
+// --duration simulated seconds (default 600) and report ticks per second.
+
+#define BENCH_DEFAULT_MIN_TIME_S 0.5
+#define BENCH_DEFAULT_DURATION_S 600.0
+#define BENCH_LANE_TICKS 50
+#define BENCH_TRANSITION_TICKS 100
+
+// The simulation sources reference these; nothing is read from disk.
+IntersectionGrid network;
+unsigned long long simulationTimeMs = 0;
+const char* basedir = "";
+const char* files[4] = { "", "", "", "" };
+const char* logFiles[4] = { "", "", "", "" };
+const char* backpressureFile = "";
+
+// Allocation counting needs the linker to route malloc through here:
+//   -DBENCH_COUNT_ALLOCS -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+// Without it every allocation figure is reported as null.
+static PlatformAtomicInt allocationCount = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    platformAtomicAdd(&allocationCount, 1);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    platformAtomicAdd(&allocationCount, 1);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    platformAtomicAdd(&allocationCount, 1);
+    return __real_realloc(p, size);
+}
+#endif
+
+// Results of measured calls that nothing else reads are stored here, so the
+// compiler cannot drop the calls.
+static volatile long long benchSink;
+
+typedef struct {
+    FILE* out;
+    int first;
+    double minTimeSeconds;
+} BenchReport;
+
+// Micro allocations are per operation, so they do not depend on how many
+// repetitions --min-time allowed. Leaves the JSON object open for extra fields.
+static void beginMicro(BenchReport* r, const char* name, int vehicles,
+    unsigned long long ops, unsigned long long ns, long allocations) {
+    fprintf(r->out, "%s\n    {\"name\": \"%s\", \"vehicles\": %d, \"ops\": %llu, \"ns_per_op\": %.2f, \"allocations_per_op\": ",
+        r->first ? "" : ",", name, vehicles, ops, ops ? (double)ns / ops : 0.0);
+#ifdef BENCH_COUNT_ALLOCS
+    fprintf(r->out, "%.4f", ops ? (double)allocations / ops : 0.0);
+#else
+    (void)allocations;
+    fprintf(r->out, "null");
+#endif
+    r->first = 0;
+    fprintf(stderr, "%-24s %6d vehicles  %10.2f ns/op\n", name, vehicles, ops ? (double)ns / ops : 0.0);
+}
+
+static void reportMicro(BenchReport* r, const char* name, int vehicles,
+    unsigned long long ops, unsigned long long ns, long allocations) {
+    beginMicro(r, name, vehicles, ops, ns, allocations);
+    fprintf(r->out, "}");
+}
+
+static int haveMeasuredEnough(const BenchReport* r, unsigned long long ns) {
+    return ns >= (unsigned long long)(r->minTimeSeconds * 1e9);
+}
+
+static Vehicle makeVehicle(int id, float x, float y, int road) {
+    Vehicle v;
+    memset(&v, 0, sizeof(v));
+    v.id = id;
+    v.x = x;
+    v.y = y;
+    v.fromRoad = road;
+    snprintf(v.name, NAME_MAX, "B%05d", id % 100000);
+    return v;
+}
+
+// Steady-state insert + remove pairs on a lane already holding n vehicles.
+static void benchQueueInsertRemove(BenchReport* r, int n) {
+    Lane lane;
+    queueInitialize(&lane);
+    Vehicle v = makeVehicle(0, 0.0f, 0.0f, 0);
+    for (int i = 0; i < n; i++) queueInsert(&lane, v);
+
+    unsigned long long ops = 0, ns = 0;
+    long allocations = platformAtomicLoad(&allocationCount);
+    Vehicle out;
+    while (!haveMeasuredEnough(r, ns)) {
+        unsigned long long start = platformNowNs();
+        for (int i = 0; i < 10000; i++) {
+            v.id = i;
+            queueInsert(&lane, v);
+            queueRemove(&lane, &out);
+        }
+        ns += platformNowNs() - start;
+        ops += 10000;
+    }
+    reportMicro(r, "queue_insert_remove", n, ops, ns, platformAtomicLoad(&allocationCount) - allocations);
+    queueRelease(&lane);
+}
+
+// Filling an empty lane to n, growth included.
+static void benchQueueFill(BenchReport* r, int n) {
+    unsigned long long ops = 0, ns = 0;
+    long allocations = 0;
+    Vehicle v = makeVehicle(0, 0.0f, 0.0f, 0);
+    while (!haveMeasuredEnough(r, ns)) {
+        Lane lane;
+        queueInitialize(&lane);
+        long before = platformAtomicLoad(&allocationCount);
+        unsigned long long start = platformNowNs();
+        for (int i = 0; i < n; i++) {
+            v.id = i;
+            queueInsert(&lane, v);
+        }
+        ns += platformNowNs() - start;
+        allocations += platformAtomicLoad(&allocationCount) - before;
+        ops += n;
+        queueRelease(&lane);
+    }
+    reportMicro(r, "queue_fill", n, ops, ns, allocations);
+}
+
+// Tombstone every third vehicle, then compact.
+static void benchQueueMarkCompact(BenchReport* r, int n) {
+    Lane lane;
+    queueInitialize(&lane);
+    Vehicle v = makeVehicle(0, 0.0f, 0.0f, 0);
+    unsigned long long ops = 0, ns = 0;
+    long allocations = 0;
+    while (!haveMeasuredEnough(r, ns)) {
+        while (lane.count < n) queueInsert(&lane, v);
+        long before = platformAtomicLoad(&allocationCount);
+        unsigned long long start = platformNowNs();
+        for (int i = 0; i < lane.count; i += 3) queueMarkRemoved(&lane, i, NULL);
+        queueCompact(&lane);
+        ns += platformNowNs() - start;
+        allocations += platformAtomicLoad(&allocationCount) - before;
+        ops += n;
+    }
+    reportMicro(r, "queue_mark_compact", n, ops, ns, allocations);
+    queueRelease(&lane);
+}
+
+typedef enum {
+    LANE_LAYOUT_LINE,        // one line, in queue order: the vector kernel path
+    LANE_LAYOUT_JITTER,      // in order but off the line: the ordered scalar path
+    LANE_LAYOUT_UNORDERED    // last two swapped: the whole-lane scan
+} LaneLayout;
+
+// Road A lane 2, front vehicle just short of the stop zone, the rest queued
+// at a spacing where followers interact.
+static void buildLane(Lane* lane, int n, LaneLayout layout) {
+    const RoadTraits* t = &roadTraits[0];
+    float sx, sy;
+    calculateSpawnPosition(0, mapLogicalLaneToPhysical(0, 2), &sx, &sy);
+    float p0 = measureRoadProgress(t, sx, sy);
+
+    queueRelease(lane);
+    for (int i = 0; i < n; i++) {
+        int place = i;
+        if (layout == LANE_LAYOUT_UNORDERED && n >= 2 && i >= n - 2) place = i == n - 1 ? n - 2 : n - 1;
+        float delta = t->stopLine - STOPPING_DISTANCE - 10.0f - place * (MIN_FRONT_SPACING - 1.0f) - p0;
+        float lateral = layout == LANE_LAYOUT_JITTER && (i & 1) ? 0.5f : 0.0f;
+        queueInsert(lane, makeVehicle(i, sx + t->alongX * delta + t->acrossX * lateral,
+            sy + t->alongY * delta + t->acrossY * lateral, 0));
+    }
+}
+
+static void benchLaneUpdate(BenchReport* r, const char* name, int n, LaneLayout layout, int hasGreen) {
+    Lane lane;
+    queueInitialize(&lane);
+    unsigned long long updates = 0, ns = 0;
+    long allocations = 0;
+    int tick = BENCH_LANE_TICKS;
+    while (!haveMeasuredEnough(r, ns)) {
+        if (tick == BENCH_LANE_TICKS) {
+            buildLane(&lane, n, layout);
+            tick = 0;
+        }
+        long before = platformAtomicLoad(&allocationCount);
+        int count = lane.count;
+        unsigned long long start = platformNowNs();
+        updateLaneVehiclesToIntersection(&lane, 0, hasGreen);
+        queueCompact(&lane);
+        ns += platformNowNs() - start;
+        allocations += platformAtomicLoad(&allocationCount) - before;
+        updates += count;
+        tick++;
+    }
+    reportMicro(r, name, n, updates, ns, allocations);
+    queueRelease(&lane);
+}
+
+// Probes a point in the neighbouring lane, so every call scans the whole lane.
+static void benchCollisionScan(BenchReport* r, int n) {
+    Lane lane;
+    queueInitialize(&lane);
+    buildLane(&lane, n, LANE_LAYOUT_LINE);
+    float sx, sy;
+    calculateSpawnPosition(0, mapLogicalLaneToPhysical(0, 1), &sx, &sy);
+
+    unsigned long long ops = 0, ns = 0;
+    long long hits = 0;
+    while (!haveMeasuredEnough(r, ns)) {
+        unsigned long long start = platformNowNs();
+        for (int i = 0; i < 100; i++) hits += detectCollisionInLane(&lane, sx, sy, -1);
+        ns += platformNowNs() - start;
+        ops += 100;
+    }
+    benchSink = hits;
+    beginMicro(r, "collision_scan", n, ops, ns, 0);
+    fprintf(r->out, ", \"hits_per_op\": %.4f}", ops ? (double)hits / ops : 0.0);
+    queueRelease(&lane);
+}
+
+// n vehicles scattered over the intersection box, each heading for a random
+// exit; stepped until the pool drains or BENCH_TRANSITION_TICKS pass.
+static void benchTransitions(BenchReport* r, int n) {
+    static Intersection in;
+    SignalPriority priority;
+    memset(&priority, 0, sizeof(priority));
+    SimRandom random;
+    simRandomSeed(&random, 12345);
+
+    unsigned long long updates = 0, ns = 0;
+    long allocations = 0;
+    while (!haveMeasuredEnough(r, ns)) {
+        memset(&in, 0, sizeof(in));
+        intersectionInitialize(&in, 1, SIGNAL_POLICY_FIXED, &priority);
+        for (int i = 0; i < n && i < MAX_TRANSITIONS; i++) {
+            float x = SCREEN_W / 2.0f + simRandomRange(&random, -ROAD_W / 2, ROAD_W / 2);
+            float y = SCREEN_H / 2.0f + simRandomRange(&random, -ROAD_W / 2, ROAD_W / 2);
+            int road = simRandomRange(&random, 0, 3);
+            insertVehicleIntoTransition(&in.transitions, makeVehicle(i, x, y, road), (road + 2) % 4);
+        }
+
+        long before = platformAtomicLoad(&allocationCount);
+        for (int tick = 0; tick < BENCH_TRANSITION_TICKS && in.transitions.count > 0; tick++) {
+            int count = in.transitions.count;
+            unsigned long long start = platformNowNs();
+            processIntersectionTransitions(&in, (unsigned long long)tick * SIM_TICK_MS);
+            ns += platformNowNs() - start;
+            updates += count;
+        }
+        allocations += platformAtomicLoad(&allocationCount) - before;
+        intersectionRelease(&in);
+    }
+    reportMicro(r, "transitions", n, updates, ns, allocations);
+}
+
+typedef struct {
+    const char* name;
+    float baseRate;    // vehicles per second per road
+    float peakRate;    // rush hour: rate at the middle of the run
+    float surgeRate;   // surge: rate on road A
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { "uniform", 0.4f, 0.4f, 0.4f },
+    { "rush_hour", 0.1f, 1.2f, 0.0f },
+    { "single_road_surge", 0.1f, 0.1f, 4.0f },
+};
+
+static float scenarioRate(const Scenario* s, int road, double fraction) {
+    if (s->surgeRate > s->baseRate && road == 0) return s->surgeRate;
+    double wave = sin(M_PI * fraction);
+    return (float)(s->baseRate + (s->peakRate - s->baseRate) * wave * wave);
+}
+
+static void runScenario(BenchReport* r, const Scenario* s, double durationSeconds, unsigned long long seed) {
+    SimulationConfig config;
+    memset(&config, 0, sizeof(config));
+    config.seed = seed;
+    config.policy = SIGNAL_POLICY_FIXED;
+    config.priority.lane = 2;
+    config.rows = 1;
+    config.cols = 1;
+    config.threads = 1;
+    if (!simulationInitialize(&config)) {
+        fprintf(stderr, "[ERROR] Cannot initialise the simulation\n");
+        return;
+    }
+
+    SimRandom arrivals;
+    simRandomSeed(&arrivals, seed + 1);
+    unsigned long long endMs = (unsigned long long)(durationSeconds * 1000.0);
+    unsigned long long spawned = 0, blocked = 0, stepNs = 0;
+    int peakVehicles = 0, nextId = 0;
+    long allocations = platformAtomicLoad(&allocationCount);
+
+    while (simulationTimeMs < endMs) {
+        double fraction = (double)simulationTimeMs / endMs;
+        for (int road = 0; road < 4; road++) {
+            // Bernoulli arrivals, at most one per road per tick.
+            float p = scenarioRate(s, road, fraction) * SIM_TICK_MS / 1000.0f;
+            if (simRandomNext(&arrivals) % 1000000 >= (unsigned int)(p * 1000000.0f)) continue;
+
+            VehicleRecord rec;
+            rec.id = nextId++;
+            rec.lane = simRandomRange(&arrivals, 1, 3);
+            snprintf(rec.name, NAME_MAX, "S%06d", rec.id % 1000000);
+            if (spawnVehicleFromRecord(&network.cells[0], road, &rec, (unsigned int)simulationTimeMs)) spawned++;
+            else blocked++;
+        }
+
+        unsigned long long start = platformNowNs();
+        simulationStep();
+        stepNs += platformNowNs() - start;
+
+        int vehicles = simulationVehicleCount();
+        if (vehicles > peakVehicles) peakVehicles = vehicles;
+    }
+    allocations = platformAtomicLoad(&allocationCount) - allocations;
+
+    const SimulationStats* st = simulationGetStats();
+    double seconds = stepNs > 0 ? stepNs / 1e9 : 1e-9;
+    fprintf(r->out, "%s\n    {\"name\": \"%s\", \"simulated_s\": %.1f, \"ticks\": %llu, \"ticks_per_s\": %.1f, "
+        "\"vehicle_updates_per_s\": %.1f, \"spawned\": %llu, \"spawn_blocked\": %llu, \"exited\": %llu, "
+        "\"peak_vehicles\": %d, \"allocations\": ",
+        r->first ? "" : ",", s->name, simulationTimeMs / 1000.0, st->ticks, st->ticks / seconds,
+        st->vehicleUpdates / seconds, spawned, blocked, st->vehiclesExited, peakVehicles);
+#ifdef BENCH_COUNT_ALLOCS
+    fprintf(r->out, "%ld", allocations);
+#else
+    fprintf(r->out, "null");
+#endif
+    fprintf(r->out, ", \"digest\": \"%016llx\"}", simulationStateDigest());
+    r->first = 0;
+    fprintf(stderr, "%-24s %10.0f ticks/s  peak %d vehicles\n", s->name, st->ticks / seconds, peakVehicles);
+
+    simulationShutdown();
+}
+
+int main(int argc, char* argv[]) {
+    const char* outPath = NULL;
+    const char* label = "";
+    double minTime = BENCH_DEFAULT_MIN_TIME_S;
+    double duration = BENCH_DEFAULT_DURATION_S;
+    unsigned long long seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) label = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) minTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) duration = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else {
+            printf("Usage: benchmark [--out file.json] [--label name] [--min-time s] [--duration s] [--seed n]\n");
+            return 1;
+        }
+    }
+
+    BenchReport report;
+    report.out = outPath ? fopen(outPath, "w") : stdout;
+    report.minTimeSeconds = minTime;
+    if (!report.out) {
+        printf("[ERROR] Cannot write %s\n", outPath);
+        return 1;
+    }
+
+    static const int sizes[] = { 10, 100, 10000 };
+    fprintf(report.out, "{\n  \"label\": \"%s\",\n  \"lane_kernel\": \"%s\",\n  \"seed\": %llu,\n  \"micro\": [",
+        label, laneKernelName(), seed);
+    report.first = 1;
+    for (int s = 0; s < 3; s++) {
+        int n = sizes[s];
+        benchQueueInsertRemove(&report, n);
+        benchQueueFill(&report, n);
+        benchQueueMarkCompact(&report, n);
+        benchCollisionScan(&report, n);
+        benchLaneUpdate(&report, "lane_update_kernel", n, LANE_LAYOUT_LINE, 0);
+        benchLaneUpdate(&report, "lane_update_kernel_green", n, LANE_LAYOUT_LINE, 1);
+        benchLaneUpdate(&report, "lane_update_scalar", n, LANE_LAYOUT_JITTER, 0);
+        benchLaneUpdate(&report, "lane_update_unordered", n, LANE_LAYOUT_UNORDERED, 0);
+    }
+    benchTransitions(&report, 16);
+    benchTransitions(&report, 64);
+    benchTransitions(&report, MAX_TRANSITIONS);
+
+    fprintf(report.out, "\n  ],\n  \"macro\": [");
+    report.first = 1;
+    for (int s = 0; s < (int)(sizeof(scenarios) / sizeof(scenarios[0])); s++) {
+        runScenario(&report, &scenarios[s], duration, seed);
+    }
+    fprintf(report.out, "\n  ]\n}\n");
+
+    if (outPath) fclose(report.out);
+    return 0;
+}
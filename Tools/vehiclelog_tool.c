@@ -0,0 +1,157 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../Src/vehiclelog.h"
+
+// Debug helper for binary lane logs:
+//   vehiclelog_tool info   <log.bin>
+//   vehiclelog_tool export <log.bin> [out.txt]
+//   vehiclelog_tool import <in.txt> <log.bin> [batch size]
+
+#define DEFAULT_IMPORT_BATCH 256
+
+static unsigned char* readWholeFile(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    unsigned char* data = malloc((size_t)length);
+    if (data && fread(data, 1, (size_t)length, f) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t)length;
+    return data;
+}
+
+// Walks every batch, handing verified records to out (if given) and
+// reporting totals. Returns 0 if the file is not a readable log.
+static int scanLog(const char* path, FILE* out) {
+    size_t size;
+    unsigned char* data = readWholeFile(path, &size);
+    if (!data) {
+        printf("[ERROR] Cannot read log: %s\n", path);
+        return 0;
+    }
+
+    VehicleLogHeader header;
+    if (vehicleLogReadHeader(data, size, &header) != VEHICLE_LOG_OK) {
+        printf("[ERROR] Not a vehicle log (or unsupported version): %s\n", path);
+        free(data);
+        return 0;
+    }
+
+    size_t offset = sizeof(VehicleLogHeader);
+    int batches = 0, records = 0, corrupt = 0;
+    for (;;) {
+        const VehicleLogRecord* batch;
+        int count;
+        size_t next = offset;
+        VehicleLogStatus status = vehicleLogNextBatch(data, size, &next, &batch, &count);
+        if (status == VEHICLE_LOG_INCOMPLETE) break;
+        if (status == VEHICLE_LOG_CORRUPT) {
+            corrupt++;
+            if (next == offset) break;
+            offset = next;
+            continue;
+        }
+
+        for (int i = 0; out && i < count; i++) {
+            char name[VEHICLE_LOG_NAME_MAX + 1];
+            memcpy(name, batch[i].name, VEHICLE_LOG_NAME_MAX);
+            name[VEHICLE_LOG_NAME_MAX] = '\0';
+            fprintf(out, "%d %s %d\n", batch[i].id, name, batch[i].lane);
+        }
+        batches++;
+        records += count;
+        offset = next;
+    }
+
+    fprintf(stderr, "%s: version %u, session %08x, %d batches, %d records, %d corrupt, %zu trailing bytes\n",
+        path, header.version, header.sessionId, batches, records, corrupt, size - offset);
+    free(data);
+    return 1;
+}
+
+static int importText(const char* inPath, const char* outPath, int batchSize) {
+    FILE* in = fopen(inPath, "r");
+    if (!in) {
+        printf("[ERROR] Cannot open file: %s\n", inPath);
+        return 0;
+    }
+
+    VehicleLogWriter w;
+    if (!vehicleLogCreate(&w, outPath, (uint32_t)time(NULL))) {
+        printf("[ERROR] Cannot create log: %s\n", outPath);
+        fclose(in);
+        return 0;
+    }
+
+    VehicleLogRecord* batch = calloc((size_t)batchSize, sizeof(VehicleLogRecord));
+    int pending = 0, total = 0;
+    char line[128];
+    while (batch && fgets(line, sizeof(line), in)) {
+        VehicleLogRecord* r = &batch[pending];
+        char name[64];
+        if (sscanf(line, "%d %63s %d", &r->id, name, &r->lane) != 3) continue;
+
+        size_t nameLength = strlen(name);
+        if (nameLength > VEHICLE_LOG_NAME_MAX - 1) nameLength = VEHICLE_LOG_NAME_MAX - 1;
+        memset(r->name, 0, sizeof(r->name));
+        memcpy(r->name, name, nameLength);
+        if (++pending == batchSize) {
+            vehicleLogAppendBatch(&w, batch, pending);
+            total += pending;
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        vehicleLogAppendBatch(&w, batch, pending);
+        total += pending;
+    }
+
+    printf("Imported %d records into %s\n", total, outPath);
+    free(batch);
+    vehicleLogClose(&w);
+    fclose(in);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "info") == 0) {
+        return scanLog(argv[2], NULL) ? 0 : 1;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "export") == 0) {
+        FILE* out = argc >= 4 ? fopen(argv[3], "w") : stdout;
+        if (!out) {
+            printf("[ERROR] Cannot open file: %s\n", argv[3]);
+            return 1;
+        }
+        int ok = scanLog(argv[2], out);
+        if (out != stdout) fclose(out);
+        return ok ? 0 : 1;
+    }
+
+    if (argc >= 4 && strcmp(argv[1], "import") == 0) {
+        int batchSize = argc >= 5 ? atoi(argv[4]) : DEFAULT_IMPORT_BATCH;
+        if (batchSize <= 0 || batchSize > VEHICLE_LOG_MAX_BATCH) batchSize = DEFAULT_IMPORT_BATCH;
+        return importText(argv[2], argv[3], batchSize) ? 0 : 1;
+    }
+
+    printf("Usage:\n");
+    printf("  %s info <log.bin>\n", argv[0]);
+    printf("  %s export <log.bin> [out.txt]\n", argv[0]);
+    printf("  %s import <in.txt> <log.bin> [batch size]\n", argv[0]);
+    return 1;
+}
@@ -2,30 +2,61 @@
 #define CONFIG_H
 
 #define _CRT_SECURE_NO_WARNINGS
-#include <SDL.h>
-#include <SDL_ttf.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-#include <windows.h>
 #include <math.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#define sleep_ms(x) Sleep(x)
+#define TRAFFIC_SHARED_DIR "C:\\TrafficShared\\"
+#else
+#include <unistd.h>
+#define sleep_ms(x) usleep((x) * 1000)
+#define TRAFFIC_SHARED_DIR "/tmp/TrafficShared/"
+#endif
+
 // Configuration Constants
 #define SCREEN_W 900
 #define SCREEN_H 900
 #define ROAD_W 200
 #define LANE_W (ROAD_W/3.0f)
-#define MAX_QUEUE 50
+#define MAX_TRANSITIONS 256
+#define LANE_INITIAL_CAPACITY 16
 #define VEHICLE_SPEED 2.0f
 #define VEHICLE_SIZE 12
 #define STOPPING_DISTANCE 30.0f
 #define MIN_SPACING 20.0f
 #define MIN_FRONT_SPACING 25.0f
-#define sleep_ms(x) Sleep(x)
+#define TRANSITION_CONFLICT_RADIUS (MIN_FRONT_SPACING * 1.5f)
+#define SIM_TICK_MS 16
+#define SIM_MAX_CATCHUP_MS 250
+#define FILE_POLL_INTERVAL_MS 200
+#define LIGHT_CYCLE_MS 5000
+#define SIGNAL_MIN_GREEN_MS 2000
+#define SIGNAL_MAX_GREEN_MS 15000
+#define PRIORITY_ENTER_COUNT 10
+#define PRIORITY_EXIT_COUNT 4
+#define PRIORITY_MAX_WAIT_MS 20000
+#define STUCK_CLEANUP_INTERVAL_MS 5000
+#define HEADLESS_DEFAULT_DURATION_S 3600
 #define GREEN_LIGHT 0
 #define RED_LIGHT 1
 #define NAME_MAX 16
+#define INGEST_READ_CHUNK 65536
+#define INGEST_SIGNATURE_BYTES 32
+#define INGEST_RING_CAPACITY 1024
+#define PENDING_SPAWN_CAPACITY 64
+#define BACKPRESSURE_PUBLISH_MS 200
+#define REPLAY_MIN_GAP_MS 200
+#define REPLAY_MAX_GAP_MS 800
+#define GRID_MAX_INTERSECTIONS 256
+#define PROFILE_DEFAULT_INTERVAL_S 5.0
+#define METRICS_SAMPLE_MS 1000
+#define METRICS_DEFAULT_INTERVAL_S 60.0
+#define SNAPSHOT_DEFAULT_INTERVAL_S 60.0
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -5,25 +5,264 @@
 #include "geometry.h"
 #include "physics.h"
 #include "transition.h"
-#include "renderer.h"
 #include "fileio.h"
+#include "simulation.h"
+#include "ingest.h"
+#include "replay.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include <limits.h>
+
+#ifndef SIM_HEADLESS_ONLY
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "renderer.h"
+#endif
 
 // Define globals here
-RoadData roads[4];
-TransitionVehicle transitions[MAX_QUEUE];
-int transitionCount = 0;
-int currentGreen = 0;
-int lightState = GREEN_LIGHT;
+IntersectionGrid network;
+unsigned long long simulationTimeMs = 0;
 
-const char* basedir = "C:\\TrafficShared\\";
+const char* basedir = TRAFFIC_SHARED_DIR;
 const char* files[4] = {
-    "C:\\TrafficShared\\lanea.txt",
-    "C:\\TrafficShared\\laneb.txt",
-    "C:\\TrafficShared\\lanec.txt",
-    "C:\\TrafficShared\\laned.txt"
+    TRAFFIC_SHARED_DIR "lanea.txt",
+    TRAFFIC_SHARED_DIR "laneb.txt",
+    TRAFFIC_SHARED_DIR "lanec.txt",
+    TRAFFIC_SHARED_DIR "laned.txt"
 };
+const char* logFiles[4] = {
+    TRAFFIC_SHARED_DIR "lanea.bin",
+    TRAFFIC_SHARED_DIR "laneb.bin",
+    TRAFFIC_SHARED_DIR "lanec.bin",
+    TRAFFIC_SHARED_DIR "laned.bin"
+};
+const char* backpressureFile = TRAFFIC_SHARED_DIR "backpressure.txt";
 
-int main(int argc, char* argv[]) {
+typedef struct {
+    int headless;
+    double durationSeconds;
+    int durationGiven;
+    unsigned long long seed;
+    const char* replayPath;
+    double speed;   // simulated seconds per wall second in a window; 0 = max
+    SignalPolicy signalPolicy;
+    int compareSignals;   // headless: run once per policy on the same input
+    SignalPriority priority;
+    int gridRows, gridCols;
+    int threads;
+    int parallelLanes;
+    int eventDriven;   // jump over idle stretches instead of stepping every tick
+    const char* profilePath;
+    double profileIntervalSeconds;
+    int profileOverlay;
+    const char* metricsPath;
+    double metricsIntervalSeconds;
+    const char* sharedRingName;   // NULL = read the lane files
+    const char* snapshotPrefix;   // NULL = no periodic snapshots
+    double snapshotIntervalSeconds;
+    const char* restorePath;
+} RunOptions;
+
+// "A2" -> road 0, lane 2.
+static int parsePriorityLane(const char* s, SignalPriority* p) {
+    char road = s[0];
+    if (road >= 'a' && road <= 'd') road -= 'a' - 'A';
+    if (road < 'A' || road > 'D' || (s[1] != '1' && s[1] != '2') || s[2] != '\0') return 0;
+    p->enabled = 1;
+    p->road = road - 'A';
+    p->lane = s[1] - '0';
+    return 1;
+}
+
+// "3x4" -> 3 rows, 4 columns.
+static int parseGridSize(const char* s, int* rows, int* cols) {
+    char* end;
+    long r = strtol(s, &end, 10);
+    if (end == s || (*end != 'x' && *end != 'X')) return 0;
+    const char* rest = end + 1;
+    long c = strtol(rest, &end, 10);
+    if (end == rest || *end != '\0' || r < 1 || c < 1 || r * c > GRID_MAX_INTERSECTIONS) return 0;
+    *rows = (int)r;
+    *cols = (int)c;
+    return 1;
+}
+
+static SimulationConfig makeSimulationConfig(const RunOptions* opt, SignalPolicy policy) {
+    SimulationConfig config;
+    config.seed = opt->seed;
+    config.policy = policy;
+    config.priority = opt->priority;
+    config.rows = opt->gridRows;
+    config.cols = opt->gridCols;
+    config.threads = opt->threads;
+    config.parallelLanes = opt->parallelLanes;
+    return config;
+}
+
+static double wallClockSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int loadReplay(const RunOptions* opt) {
+    if (!opt->replayPath) return 1;
+
+    int count = replayLoad(opt->replayPath, opt->seed);
+    if (count < 0) {
+        printf("[ERROR] Cannot open replay file: %s\n", opt->replayPath);
+        return 0;
+    }
+    printf("Replaying %d vehicles from %s\n", count, opt->replayPath);
+    return 1;
+}
+
+// Replaces the freshly initialized network with a saved one; the run then
+// continues from the snapshot's simulated time.
+static int restoreSnapshot(const RunOptions* opt) {
+    if (!opt->restorePath) return 1;
+
+    SnapshotStatus status = snapshotLoad(opt->restorePath);
+    if (status != SNAPSHOT_OK) {
+        printf("[ERROR] Snapshot %s %s\n", opt->restorePath, snapshotStatusMessage(status));
+        return 0;
+    }
+    printf("Restored snapshot at %.1f s from %s\n", simulationTimeMs / 1000.0, opt->restorePath);
+    return 1;
+}
+
+static void printSignalStats(const RunOptions* opt) {
+    SignalPolicyStats totals[SIGNAL_POLICY_COUNT];
+    simulationSignalStats(totals);
+    signalControllerPrintStats(totals, &opt->priority);
+}
+
+static int runHeadlessOnce(const RunOptions* opt, SignalPolicy policy, SignalPolicyStats* totals) {
+    if (!loadReplay(opt)) return 1;
+    SimulationConfig config = makeSimulationConfig(opt, policy);
+    if (!simulationInitialize(&config)) {
+        printf("[ERROR] Cannot allocate a %dx%d network\n", opt->gridRows, opt->gridCols);
+        replayRelease();
+        return 1;
+    }
+    if (!restoreSnapshot(opt)) {
+        simulationShutdown();
+        replayRelease();
+        return 1;
+    }
+
+    // A replay without an explicit duration runs until its traffic has
+    // cleared, however late the last arrival is.
+    int untilCleared = !opt->durationGiven && replayIsActive();
+    unsigned long long endMs = untilCleared ? ULLONG_MAX : (unsigned long long)(opt->durationSeconds * 1000.0);
+    double start = wallClockSeconds();
+
+    while (simulationTimeMs < endMs) {
+        if (untilCleared && replayIsFinished() && simulationVehicleCount() == 0 && countPendingSpawns() == 0) break;
+        if (opt->eventDriven && simulationSkipIdle(endMs) > 0 && simulationTimeMs >= endMs) break;
+        simulationStep();
+        profilerTick();
+    }
+
+    double elapsed = wallClockSeconds() - start;
+    if (elapsed <= 0.0) elapsed = 1e-9;
+
+    const SimulationStats* s = simulationGetStats();
+    printf("=== Headless Run Complete ===\n");
+    printf("Seed: %llu\n", opt->seed);
+    printf("Signal policy: %s\n", signalPolicyName(policy));
+    printf("Network: %dx%d intersections on %d threads (%s tasks)\n", network.rows, network.cols,
+        simulationThreadCount(), opt->parallelLanes ? "lane" : "intersection");
+    printf("Simulated time: %.1f s\n", simulationTimeMs / 1000.0);
+    printf("Wall time: %.3f s (%.1fx realtime)\n", elapsed, simulationTimeMs / 1000.0 / elapsed);
+    printf("Ticks: %llu (%.0f ticks/s)\n", s->ticks, s->ticks / elapsed);
+    if (opt->eventDriven) {
+        printf("Event engine: %llu ticks (%.1f%%) skipped in %llu idle stretches\n", s->idleTicksSkipped,
+            s->ticks ? 100.0 * s->idleTicksSkipped / s->ticks : 0.0, s->idleSkips);
+    }
+    printf("Vehicle updates: %llu (%.0f simulated vehicles/s)\n", s->vehicleUpdates, s->vehicleUpdates / elapsed);
+    printf("Vehicles entered intersection: %llu\n", s->vehiclesEntered);
+    if (network.count > 1) {
+        printf("Vehicles handed between intersections: %llu\n", s->handOffs);
+    }
+    printf("Vehicles left the network: %llu\n", s->vehiclesExited);
+    if (countCorruptLogBatches() > 0) {
+        printf("Corrupt log batches skipped: %llu\n", countCorruptLogBatches());
+    }
+    printf("State digest: %016llx\n", simulationStateDigest());
+    printSignalStats(opt);
+    if (totals) simulationSignalStats(totals);
+
+    simulationShutdown();
+    metricsPrintSummary();
+    replayRelease();
+    return 0;
+}
+
+static int runHeadless(const RunOptions* opt) {
+    if (!opt->compareSignals) return runHeadlessOnce(opt, opt->signalPolicy, NULL);
+
+    SignalPolicyStats results[SIGNAL_POLICY_COUNT];
+    for (int p = 0; p < SIGNAL_POLICY_COUNT; p++) {
+        SignalPolicyStats totals[SIGNAL_POLICY_COUNT];
+        if (runHeadlessOnce(opt, (SignalPolicy)p, totals) != 0) return 1;
+        results[p] = totals[p];
+        printf("\n");
+    }
+
+    printf("=== Signal Policy Comparison ===\n");
+    for (int p = 0; p < SIGNAL_POLICY_COUNT; p++) {
+        double minutes = results[p].activeMs / 60000.0;
+        if (minutes <= 0.0) minutes = 1e-9;
+        printf("%-8s  %8llu cleared  %7.1f/min  %6llu switches  idle green %5.1f%%\n",
+            signalPolicyName((SignalPolicy)p), results[p].cleared, results[p].cleared / minutes,
+            results[p].switches, 100.0 * results[p].idleGreenMs / (minutes * 60000.0));
+    }
+    return 0;
+}
+
+#ifndef SIM_HEADLESS_ONLY
+static void printIngestStats(void) {
+    IngestStats s;
+    ingestGetStats(&s);
+    printf("Ingest: %llu records delivered\n", s.delivered);
+    if (ingestSharedRingActive()) return;
+    for (int r = 0; r < 4; r++) {
+        printf("  road %d: ring high-water %ld/%d, reader stalled %ld times\n",
+            r, s.highWater[r], INGEST_RING_CAPACITY - 1, s.stalls[r]);
+    }
+}
+
+// Every intersection is drawn in its own local frame, scaled down so the
+// whole grid fits the window.
+static void renderNetwork(SDL_Renderer* renderer) {
+    int span = network.rows > network.cols ? network.rows : network.cols;
+    float scale = 1.0f / span;
+
+    SDL_RenderSetScale(renderer, scale, scale);
+    for (int i = 0; i < network.count; i++) {
+        const Intersection* in = &network.cells[i];
+        SDL_Rect cell = { in->col * SCREEN_W, in->row * SCREEN_H, SCREEN_W, SCREEN_H };
+        SDL_RenderSetViewport(renderer, &cell);
+
+        PROFILE_BEGIN(PROFILE_RENDER_SCENE);
+        renderStaticScene(renderer);
+        PROFILE_END(PROFILE_RENDER_SCENE);
+
+        PROFILE_BEGIN(PROFILE_RENDER_VEHICLES);
+        renderAllVehicles(renderer, in);
+        PROFILE_END(PROFILE_RENDER_VEHICLES);
+
+        PROFILE_BEGIN(PROFILE_RENDER_SIGNALS);
+        renderTrafficSignals(renderer, in);
+        PROFILE_END(PROFILE_RENDER_SIGNALS);
+    }
+    SDL_RenderSetViewport(renderer, NULL);
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+}
+
+static int runWindowed(const RunOptions* opt) {
     if (SDL_Init(SDL_INIT_VIDEO) != 0) return 1;
     if (TTF_Init() != 0) {
         SDL_Quit();
@@ -33,135 +272,297 @@ int main(int argc, char* argv[]) {
     SDL_Window* window = SDL_CreateWindow("Traffic Simulator - Modular",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         SCREEN_W, SCREEN_H, 0);
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
 
     TTF_Font* font = TTF_OpenFont("C:\\Windows\\Fonts\\arial.ttf", 16);
-    srand((unsigned)time(NULL));
 
-    for (int i = 0; i < 4; i++) {
-        queueInitialize(&roads[i].L1);
-        queueInitialize(&roads[i].L2);
-        queueInitialize(&roads[i].L3);
+    if (!loadReplay(opt)) return 1;
+    printf("Seed: %llu\n", opt->seed);
+    SimulationConfig config = makeSimulationConfig(opt, opt->signalPolicy);
+    if (!simulationInitialize(&config)) return 1;
+    if (!restoreSnapshot(opt)) {
+        simulationShutdown();
+        replayRelease();
+        return 1;
+    }
+    // Snapshots record the file read positions, which only match the
+    // vehicles on the road while the files are read on this thread.
+    if (!replayIsActive() && !ingestSharedRingActive() && !opt->snapshotPrefix && !ingestStart()) {
+        printf("Ingest thread unavailable; reading input files on the main thread\n");
     }
-
-    loadVehiclesFromInputFiles();
 
     int running = 1;
     SDL_Event e;
-    Uint32 lastFileCheck = 0;
-    Uint32 lastLightChange = 0;
+    Uint32 lastFrame = SDL_GetTicks();
+    double accumulator = 0.0;
+#ifdef SIM_PROFILE
+    int showProfile = opt->profileOverlay;
+#endif
 
     while (running) {
+        PROFILE_BEGIN(PROFILE_FRAME);
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) running = 0;
+            // Target texture contents are lost on device reset; rebuild the cache.
+            if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                invalidateStaticScene();
+#ifdef SIM_PROFILE
+                releaseProfilerOverlay();
+#endif
+            }
+#ifdef SIM_PROFILE
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_p) showProfile = !showProfile;
+#endif
         }
 
         Uint32 now = SDL_GetTicks();
+        if (opt->speed > 0.0) {
+            accumulator += (now - lastFrame) * opt->speed;
+            if (accumulator > SIM_MAX_CATCHUP_MS * opt->speed) accumulator = SIM_MAX_CATCHUP_MS * opt->speed;
 
-        if (now - lastFileCheck >= 200) {
-            loadVehiclesFromInputFiles();
-            lastFileCheck = now;
+            while (accumulator >= SIM_TICK_MS) {
+                if (opt->eventDriven) {
+                    unsigned long long ticks = (unsigned long long)(accumulator / SIM_TICK_MS);
+                    accumulator -= SIM_TICK_MS * (double)simulationSkipIdle(simulationTimeMs + ticks * SIM_TICK_MS);
+                    if (accumulator < SIM_TICK_MS) break;
+                }
+                simulationStep();
+                accumulator -= SIM_TICK_MS;
+            }
         }
-
-        if (now - lastLightChange >= 5000) {
-            currentGreen = (currentGreen + 1) % 4;
-            lastLightChange = now;
+        else {
+            // Max speed: step for one tick's worth of wall time, then draw.
+            do {
+                if (opt->eventDriven) simulationSkipIdle(simulationTimeMs + SIM_MAX_CATCHUP_MS);
+                simulationStep();
+            } while (SDL_GetTicks() - now < SIM_TICK_MS);
         }
+        lastFrame = now;
 
-        for (int r = 0; r < 4; r++) {
-            updateLaneVehiclesToIntersection(&roads[r].L1, r);
-            updateLaneVehiclesToIntersection(&roads[r].L2, r);
-            updateRightTurnLane(&roads[r].L3, r);
-        }
+        SDL_SetRenderDrawColor(renderer, 0,0,0,255);
+        SDL_RenderClear(renderer);
 
-        removeStuckTransitionVehicles();
-        processIntersectionTransitions();
+        renderNetwork(renderer);
+#ifdef SIM_PROFILE
+        if (showProfile) renderProfilerOverlay(renderer, font);
+#endif
 
-        // handle green light transitions for L1 and L2
-        if (currentGreen >= 0 && currentGreen < 4 && lightState == GREEN_LIGHT) {
-            // left-turn lane
-            Lane* L = &roads[currentGreen].L1;
-            int cnt = L->count;
-            for (int i = 0; i < cnt; i++) {
-                Vehicle* v = queueGetVehicleAt(L, i);
-                if (!v) continue;
+        PROFILE_BEGIN(PROFILE_PRESENT);
+        SDL_RenderPresent(renderer);
+        PROFILE_END(PROFILE_PRESENT);
+        PROFILE_END(PROFILE_FRAME);
 
-                float cx = SCREEN_W / 2.0f, cy = SCREEN_H / 2.0f;
-                int reached = 0;
+        profilerTick();
+        sleep_ms(SIM_TICK_MS);
+    }
 
-                if (currentGreen == 0 && v->y >= cy - ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 1 && v->x <= cx + ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 2 && v->y <= cy + ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 3 && v->x >= cx - ROAD_W / 2.0f) reached = 1;
+    ingestStop();
+    printIngestStats();
+    printSignalStats(opt);
+    simulationShutdown();
+    metricsPrintSummary();
+    replayRelease();
+    releaseVehicleBatches();
+    invalidateStaticScene();
+#ifdef SIM_PROFILE
+    releaseProfilerOverlay();
+#endif
 
-                if (reached) {
-                    Vehicle temp;
-                    queueRemove(L, &temp);
-                    int targetRoad = (currentGreen + 1) % 4;
-                    insertVehicleIntoTransition(temp, targetRoad);
-                    i--; cnt--;
-                }
-            }
+    if (font) TTF_CloseFont(font);
+    TTF_Quit();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
 
-            // straight lane
-            L = &roads[currentGreen].L2;
-            cnt = L->count;
-            for (int i = 0; i < cnt; i++) {
-                Vehicle* v = queueGetVehicleAt(L, i);
-                if (!v) continue;
-
-                float cx = SCREEN_W / 2.0f, cy = SCREEN_H / 2.0f;
-                int reached = 0;
-
-                if (currentGreen == 0 && v->y >= cy - ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 1 && v->x <= cx + ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 2 && v->y <= cy + ROAD_W / 2.0f) reached = 1;
-                if (currentGreen == 3 && v->x >= cx - ROAD_W / 2.0f) reached = 1;
-
-                if (reached) {
-                    Vehicle temp;
-                    queueRemove(L, &temp);
-                    int targetRoad;
-                    int opposite = (currentGreen == 0) ? 2 : (currentGreen == 1) ? 3 : (currentGreen == 2) ? 0 : 1;
-
-                    if (rand() % 2 == 0) {
-                        targetRoad = opposite;
-                    }
-                    else {
-                        targetRoad = (currentGreen + 3) % 4;
-                    }
-
-                    insertVehicleIntoTransition(temp, targetRoad);
-                    i--; cnt--;
-                }
+    return 0;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    RunOptions opt;
+    opt.headless = 0;
+    opt.durationSeconds = HEADLESS_DEFAULT_DURATION_S;
+    opt.durationGiven = 0;
+    opt.seed = (unsigned long long)time(NULL);
+    opt.replayPath = NULL;
+    opt.speed = 1.0;
+    opt.signalPolicy = SIGNAL_POLICY_FIXED;
+    opt.compareSignals = 0;
+    opt.priority.enabled = 0;
+    opt.priority.road = 0;
+    opt.priority.lane = 2;
+    opt.priority.enterCount = PRIORITY_ENTER_COUNT;
+    opt.priority.exitCount = PRIORITY_EXIT_COUNT;
+    opt.priority.maxWaitMs = PRIORITY_MAX_WAIT_MS;
+    opt.gridRows = 1;
+    opt.gridCols = 1;
+    opt.threads = 0;
+    opt.parallelLanes = 0;
+    opt.eventDriven = 0;
+    opt.profilePath = NULL;
+    opt.profileIntervalSeconds = PROFILE_DEFAULT_INTERVAL_S;
+    opt.profileOverlay = 0;
+    opt.metricsPath = NULL;
+    opt.metricsIntervalSeconds = METRICS_DEFAULT_INTERVAL_S;
+    opt.sharedRingName = NULL;
+    opt.snapshotPrefix = NULL;
+    opt.snapshotIntervalSeconds = SNAPSHOT_DEFAULT_INTERVAL_S;
+    opt.restorePath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            opt.headless = 1;
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            opt.durationSeconds = atof(argv[++i]);
+            opt.durationGiven = 1;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            opt.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            opt.replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--signal") == 0 && i + 1 < argc) {
+            i++;
+            int policy = signalPolicyFromName(argv[i]);
+            if (strcmp(argv[i], "compare") == 0) {
+                opt.compareSignals = 1;
+            }
+            else if (policy >= 0) {
+                opt.signalPolicy = (SignalPolicy)policy;
+            }
+            else {
+                printf("Unknown signal policy '%s' (fixed, lqf, pressure, compare)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--priority") == 0 && i + 1 < argc) {
+            if (!parsePriorityLane(argv[++i], &opt.priority)) {
+                printf("Priority lane must look like A2 (road A-D, lane 1 or 2)\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--priority-on") == 0 && i + 1 < argc) {
+            opt.priority.enterCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--priority-off") == 0 && i + 1 < argc) {
+            opt.priority.exitCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-wait") == 0 && i + 1 < argc) {
+            opt.priority.maxWaitMs = (unsigned long long)(atof(argv[++i]) * 1000.0);
+        }
+        else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+            if (!parseGridSize(argv[++i], &opt.gridRows, &opt.gridCols)) {
+                printf("Grid must look like 3x4 (at most %d intersections)\n", GRID_MAX_INTERSECTIONS);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opt.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--parallel") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "lanes") == 0) opt.parallelLanes = 1;
+            else if (strcmp(argv[i], "intersections") == 0) opt.parallelLanes = 0;
+            else {
+                printf("Unknown parallel mode '%s' (intersections, lanes)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "event") == 0) opt.eventDriven = 1;
+            else if (strcmp(argv[i], "tick") == 0) opt.eventDriven = 0;
+            else {
+                printf("Unknown engine '%s' (tick, event)\n", argv[i]);
+                return 1;
             }
         }
+        else if (strcmp(argv[i], "--profile-out") == 0 && i + 1 < argc) {
+            opt.profilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile-interval") == 0 && i + 1 < argc) {
+            opt.profileIntervalSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--profile-overlay") == 0) {
+            opt.profileOverlay = 1;
+        }
+        else if (strcmp(argv[i], "--metrics-out") == 0 && i + 1 < argc) {
+            opt.metricsPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+            opt.metricsIntervalSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--shm") == 0) {
+            opt.sharedRingName = VEHICLE_RING_DEFAULT_NAME;
+        }
+        else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            opt.sharedRingName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot-out") == 0 && i + 1 < argc) {
+            opt.snapshotPrefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot-every") == 0 && i + 1 < argc) {
+            opt.snapshotIntervalSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            opt.restorePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            i++;
+            opt.speed = strcmp(argv[i], "max") == 0 ? 0.0 : atof(argv[i]);
+            if (opt.speed < 0.0) opt.speed = 1.0;
+        }
+    }
 
-        SDL_SetRenderDrawColor(renderer, 0,0,0,255);
-        SDL_RenderClear(renderer);
+#ifdef SIM_HEADLESS_ONLY
+    opt.headless = 1;
+#endif
 
-        renderGradientBackground(renderer);
-        renderDecorativeTrees(renderer);
-        renderRoadNetwork(renderer);
+#ifdef SIM_PROFILE
+    if (!profilerStart(opt.profilePath, opt.profileIntervalSeconds)) {
+        printf("[ERROR] Cannot open profile output: %s\n", opt.profilePath);
+        return 1;
+    }
+#else
+    if (opt.profilePath || opt.profileOverlay) {
+        printf("Profiling is compiled out; rebuild with -DSIM_PROFILE\n");
+    }
+#endif
 
-        for (int r = 0; r < 4; r++) {
-            renderLaneVehicles(renderer, &roads[r].L1, 220, 80, 80);
-            renderLaneVehicles(renderer, &roads[r].L2, 80, 220, 80);
-            renderLaneVehicles(renderer, &roads[r].L3, 80, 120, 220);
-        }
+    if (!metricsStart(opt.metricsPath, opt.metricsIntervalSeconds)) {
+        printf("[ERROR] Cannot open metrics output: %s\n", opt.metricsPath);
+        return 1;
+    }
 
-        renderTransitionVehicles(renderer);
-        renderTrafficSignals(renderer);
+    if (opt.sharedRingName) {
+        if (!ingestOpenSharedRing(opt.sharedRingName)) {
+            printf("[ERROR] Cannot create shared vehicle ring: %s\n", opt.sharedRingName);
+            return 1;
+        }
+        printf("Reading vehicles from shared memory: %s\n", opt.sharedRingName);
+    }
 
-        SDL_RenderPresent(renderer);
-        sleep_ms(16);
+    if (!snapshotStart(opt.snapshotPrefix, opt.snapshotIntervalSeconds)) {
+        printf("[ERROR] Cannot start the snapshot writer\n");
+        ingestCloseSharedRing();
+        return 1;
     }
 
-    if (font) TTF_CloseFont(font);
-    TTF_Quit();
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    int result = 0;
+    if (opt.headless) {
+        result = runHeadless(&opt);
+    }
+#ifndef SIM_HEADLESS_ONLY
+    else {
+        result = runWindowed(&opt);
+    }
+#endif
 
-    return 0;
+    snapshotStop();
+    ingestCloseSharedRing();
+    metricsStop();
+    profilerStop();
+    return result;
 }
@@ -3,20 +3,55 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "../Src/vehiclelog.h"
+#include "../Src/backpressure.h"
+#include "../Src/vehiclering.h"
+
+#ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
+#define SHARED_DIR "C:\\TrafficShared"
+#define PATH_SEP "\\"
+#else
+// Minimal stand-ins so the generator also runs next to the headless build.
+#include <unistd.h>
+#include <sys/stat.h>
+typedef unsigned long long ULONGLONG;
+static ULONGLONG GetTickCount64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONGLONG)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+static void Sleep(unsigned int ms) { usleep(ms * 1000); }
+#define _mkdir(path) mkdir((path), 0755)
+#define SHARED_DIR "/tmp/TrafficShared"
+#define PATH_SEP "/"
+#endif
 
-const char* baseDir = "C:\\TrafficShared";
+const char* baseDir = SHARED_DIR;
 const char* files[4] = {    
-    "C:\\TrafficShared\\lanea.txt",
-    "C:\\TrafficShared\\laneb.txt",         
-    "C:\\TrafficShared\\lanec.txt",
-    "C:\\TrafficShared\\laned.txt"
+    SHARED_DIR PATH_SEP "lanea.txt",
+    SHARED_DIR PATH_SEP "laneb.txt",         
+    SHARED_DIR PATH_SEP "lanec.txt",
+    SHARED_DIR PATH_SEP "laned.txt"
 };
+const char* logFiles[4] = {
+    SHARED_DIR PATH_SEP "lanea.bin",
+    SHARED_DIR PATH_SEP "laneb.bin",
+    SHARED_DIR PATH_SEP "lanec.bin",
+    SHARED_DIR PATH_SEP "laned.bin"
+};
+const char* backpressureFile = SHARED_DIR PATH_SEP "backpressure.txt";
 
 #define DEFAULT_INTERVAL_MS 500
 #define NAME_MAX 16  
 #define MIN_SPAWN_SPACING_MS 400
+#define HIGH_RATE_DEFAULT_BATCH 256
+#define HIGH_RATE_DEFAULT_FLUSH_MS 50
+#define HIGH_RATE_MAX_PER_STEP 4096
+#define HIGH_RATE_TEXT_BUFFER (1 << 16)
+#define BACKPRESSURE_REFRESH_MS 50
+#define BACKPRESSURE_STALE_S 3
 
 typedef struct {
     ULONGLONG lastSpawnTime[3];
@@ -24,6 +59,33 @@ typedef struct {
 
 RoadSpawnTracker spawnTrackers[4] = { {{0, 0, 0}}, {{0, 0, 0}}, {{0, 0, 0}}, {{0, 0, 0}} };
 
+// --binary: write the append-only binary logs instead of text lines.
+static int useBinaryLog = 0;
+static VehicleLogWriter logWriters[4];
+
+// High-rate mode keeps every lane file open and writes records in batches.
+typedef struct {
+    VehicleLogRecord records[VEHICLE_LOG_MAX_BATCH];
+    int count;
+} RoadBatch;
+
+static RoadBatch roadBatches[4];
+static FILE* textWriters[4];
+
+// Unless --no-backpressure, a road is only written while fewer of its records
+// are unread than the simulator says it can hold (see Src/backpressure.h).
+static int useBackpressure = 1;
+static long long writtenPerRoad[4];
+static BackpressureStatus backpressure;
+static int haveBackpressure = 0;
+static ULONGLONG lastBackpressureRead = 0;
+
+// --shm: publish into the simulator's shared-memory ring instead of the lane
+// files. A full ring is the backpressure there, so the status file is unused.
+static int useSharedRing = 0;
+static const char* sharedRingName = VEHICLE_RING_DEFAULT_NAME;
+static VehicleRing sharedRing;
+
 
 static int canSpawnOnLane(int road, int lane) {
     ULONGLONG now = GetTickCount64();
@@ -36,7 +98,86 @@ static int canSpawnOnLane(int road, int lane) {
 }
 
 
+// A status older than BACKPRESSURE_STALE_S is from a simulator that has
+// stopped; the last good values stay in force so a paused run is not flooded.
+static void refresh_backpressure(void) {
+    ULONGLONG now = GetTickCount64();
+    if (lastBackpressureRead != 0 && now - lastBackpressureRead < BACKPRESSURE_REFRESH_MS) return;
+    lastBackpressureRead = now;
+
+    BackpressureStatus s;
+    if (!backpressureRead(backpressureFile, &s)) return;
+    if ((long long)time(NULL) - s.writtenAt > BACKPRESSURE_STALE_S) return;
+    backpressure = s;
+    haveBackpressure = 1;
+}
+
+
+static void open_shared_ring(void) {
+    int announced = 0;
+    while (!vehicleRingOpen(&sharedRing, sharedRingName)) {
+        if (!announced) printf("Waiting for the simulator to create %s ...\n", sharedRingName);
+        announced = 1;
+        Sleep(200);
+    }
+    printf("Connected to shared ring: %s\n", sharedRingName);
+}
+
+
+// A closed ring means the simulator has exited; wait for the next one.
+static void check_shared_ring(void) {
+    if (!vehicleRingIsClosed(&sharedRing)) return;
+    vehicleRingClose(&sharedRing);
+    printf("Simulator closed the shared ring\n");
+    open_shared_ring();
+}
+
+
+static int road_has_credit(int road) {
+    if (useSharedRing) {
+        check_shared_ring();
+        return vehicleRingFree(&sharedRing, road) > roadBatches[road].count;
+    }
+    if (!useBackpressure) return 1;
+    refresh_backpressure();
+    if (!haveBackpressure) return 1;
+
+    // consumed restarts when the simulator notices the cleared files.
+    long long unread = writtenPerRoad[road] - backpressure.consumed[road];
+    if (unread < 0) unread = 0;
+    return unread < backpressure.credit[road];
+}
+
+
+// Next road from road onwards that may be written, or -1 if none may.
+static int next_road_with_credit(int road) {
+    for (int i = 0; i < 4; i++) {
+        int r = (road + i) % 4;
+        if (road_has_credit(r)) return r;
+    }
+    return -1;
+}
+
+
+static int append_vehicle_to_log(int road, int id, const char* name, int lane) {
+    VehicleLogRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.id = id;
+    rec.lane = lane;
+    memcpy(rec.name, name, strnlen(name, VEHICLE_LOG_NAME_MAX - 1));
+
+    if (useSharedRing) return vehicleRingPublish(&sharedRing, road, &rec, 1) == 1;
+    if (!vehicleLogAppendBatch(&logWriters[road], &rec, 1)) {
+        printf("[ERROR] Cannot write log: %s\n", logFiles[road]);
+        return 0;
+    }
+    return 1;
+}
+
+
 static int append_vehicle_to_file(int road, int id, const char* name, int lane) {
+    if (useBinaryLog || useSharedRing) return append_vehicle_to_log(road, id, name, lane);
+
     FILE* f = fopen(files[road], "a");
     if (!f) {
         printf("[ERROR] Cannot open file: %s\n", files[road]);
@@ -80,6 +221,21 @@ static void clear_all_files(void) {
         else {
             printf("  ✗ Warning: Could not clear file: %s\n", files[i]);
         }
+
+        // The simulator prefers a binary log when one exists, so a stale one
+        // must not shadow a text run.
+        if (useBinaryLog) {
+            uint32_t session = (uint32_t)(time(NULL) ^ GetTickCount64()) + (uint32_t)i;
+            if (vehicleLogCreate(&logWriters[i], logFiles[i], session)) {
+                printf("  ✓ Created log: %s\n", logFiles[i]);
+            }
+            else {
+                printf("  ✗ Warning: Could not create log: %s\n", logFiles[i]);
+            }
+        }
+        else {
+            remove(logFiles[i]);
+        }
     }
     printf("\n");
 }
@@ -89,6 +245,7 @@ static void ensure_directory_exists(void) {
     if (_mkdir(baseDir) == 0) {
         printf("Created directory: %s\n", baseDir);
     } else {
+#ifdef _WIN32
         DWORD attrib = GetFileAttributesA(baseDir);
         if (attrib == INVALID_FILE_ATTRIBUTES) {
             printf("[ERROR] Cannot create directory: %s\n", baseDir);
@@ -96,13 +253,208 @@ static void ensure_directory_exists(void) {
         } else if (attrib & FILE_ATTRIBUTE_DIRECTORY) {
             printf("Using existing directory: %s\n", baseDir);
         }
+#else
+        struct stat st;
+        if (stat(baseDir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            printf("[ERROR] Cannot create directory: %s\n", baseDir);
+            exit(1);
+        }
+        printf("Using existing directory: %s\n", baseDir);
+#endif
+    }
+}
+
+
+static int open_text_writers(void) {
+    for (int i = 0; i < 4; i++) {
+        textWriters[i] = fopen(files[i], "a");
+        if (!textWriters[i]) {
+            printf("[ERROR] Cannot open file: %s\n", files[i]);
+            return 0;
+        }
+        setvbuf(textWriters[i], NULL, _IOFBF, HIGH_RATE_TEXT_BUFFER);
     }
+    return 1;
+}
+
+
+static void close_writers(void) {
+    for (int i = 0; i < 4; i++) {
+        if (textWriters[i]) fclose(textWriters[i]);
+        textWriters[i] = NULL;
+        vehicleLogClose(&logWriters[i]);
+    }
+}
+
+
+// Writes everything buffered for one road with a single flush.
+static int flush_road_batch(int road) {
+    RoadBatch* b = &roadBatches[road];
+    if (b->count == 0) return 1;
+
+    int ok;
+    if (useSharedRing) {
+        // road_has_credit() only lets a batch grow while the ring can take it.
+        ok = vehicleRingPublish(&sharedRing, road, b->records, b->count) == b->count;
+    }
+    else if (useBinaryLog) {
+        ok = vehicleLogAppendBatch(&logWriters[road], b->records, b->count);
+    }
+    else {
+        FILE* f = textWriters[road];
+        for (int i = 0; i < b->count; i++) {
+            fprintf(f, "%d %s %d\n", b->records[i].id, b->records[i].name, b->records[i].lane);
+        }
+        ok = fflush(f) == 0;
+    }
+
+    if (!ok) printf("[ERROR] Cannot write batch for road %c\n", 'A' + road);
+    b->count = 0;
+    return ok;
+}
+
+
+// rate = vehicles per second across all roads (0 = as fast as possible);
+// a road is flushed once it holds batchSize records or flushMs has passed.
+static void run_high_rate(int rate, int batchSize, int flushMs, long long limit) {
+    if (!useBinaryLog && !useSharedRing && !open_text_writers()) exit(1);
+
+    ULONGLONG start = GetTickCount64();
+    ULONGLONG lastFlush = start;
+    ULONGLONG lastReport = start;
+    long long produced = 0;
+    long long reported = 0;
+    unsigned long long flushes = 0;
+    unsigned long long throttled = 0;
+    int nextId = 1;
+    int road = 0;
+
+    while (limit <= 0 || produced < limit) {
+        ULONGLONG now = GetTickCount64();
+        long long due = HIGH_RATE_MAX_PER_STEP;
+        if (rate > 0) due = (long long)((now - start) * (ULONGLONG)rate / 1000) - produced;
+        if (due > HIGH_RATE_MAX_PER_STEP) due = HIGH_RATE_MAX_PER_STEP;
+        if (limit > 0 && due > limit - produced) due = limit - produced;
+
+        int waited = 0;
+        for (long long k = 0; k < due; k++) {
+            uint32_t space = useSharedRing ? vehicleRingSpaceSequence(&sharedRing) : 0;
+            road = next_road_with_credit(road);
+            if (road < 0) {
+                // Every road is full: hand over what is buffered and wait.
+                for (int i = 0; i < 4; i++) {
+                    if (roadBatches[i].count == 0) continue;
+                    flush_road_batch(i);
+                    flushes++;
+                }
+                // The simulator wakes us as soon as it frees a slot.
+                if (useSharedRing) {
+                    vehicleRingWaitForSpace(&sharedRing, space, 100);
+                    waited = 1;
+                }
+                road = 0;
+                due = 0;
+                throttled++;
+                break;
+            }
+
+            RoadBatch* b = &roadBatches[road];
+            VehicleLogRecord* r = &b->records[b->count++];
+            memset(r, 0, sizeof(*r));
+            r->id = nextId;
+            r->lane = choose_lane_weighted();
+            snprintf(r->name, sizeof(r->name), "veh%d", nextId);
+
+            if (b->count >= batchSize) {
+                flush_road_batch(road);
+                flushes++;
+            }
+            nextId++;
+            produced++;
+            writtenPerRoad[road]++;
+            road = (road + 1) % 4;
+        }
+
+        if (now - lastFlush >= (ULONGLONG)flushMs) {
+            for (int i = 0; i < 4; i++) {
+                if (roadBatches[i].count == 0) continue;
+                flush_road_batch(i);
+                flushes++;
+            }
+            lastFlush = now;
+        }
+
+        if (now - lastReport >= 1000) {
+            printf("[rate] %lld vehicles, %.0f/s, %llu flushes, %llu waits for the simulator\n",
+                produced, (produced - reported) * 1000.0 / (double)(now - lastReport), flushes, throttled);
+            lastReport = now;
+            reported = produced;
+        }
+
+        if (due <= 0 && !waited) Sleep(1);
+    }
+
+    for (int i = 0; i < 4; i++) flush_road_batch(i);
+
+    double seconds = (GetTickCount64() - start) / 1000.0;
+    if (seconds <= 0.0) seconds = 0.001;
+    printf("Generated %lld vehicles in %.2fs (%.0f/s)\n", produced, seconds, produced / seconds);
+    close_writers();
+    if (useSharedRing) vehicleRingClose(&sharedRing);
 }
 
 int main(int argc, char** argv) {
     int interval_ms = DEFAULT_INTERVAL_MS;
+    int highRate = 0;
+    int rate = 0;
+    int batchSize = HIGH_RATE_DEFAULT_BATCH;
+    int flushMs = HIGH_RATE_DEFAULT_FLUSH_MS;
+    long long limit = 0;
+    int seeded = 0;
+    unsigned int seed = 0;
 
     for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            useBinaryLog = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--shm") == 0) {
+            useSharedRing = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            useSharedRing = 1;
+            sharedRingName = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--no-backpressure") == 0) {
+            useBackpressure = 0;
+            continue;
+        }
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            highRate = 1;
+            rate = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchSize = atoi(argv[++i]);
+            if (batchSize < 1) batchSize = 1;
+            if (batchSize > VEHICLE_LOG_MAX_BATCH) batchSize = VEHICLE_LOG_MAX_BATCH;
+            continue;
+        }
+        if (strcmp(argv[i], "--flush-ms") == 0 && i + 1 < argc) {
+            flushMs = atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+            seeded = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            limit = atoll(argv[++i]);
+            continue;
+        }
         int t = atoi(argv[i]);
         if (t > 0) {
             interval_ms = t;
@@ -112,23 +464,46 @@ int main(int argc, char** argv) {
 
     ensure_directory_exists();
     clear_all_files();
+    if (useSharedRing) open_shared_ring();
 
-    srand((unsigned int)(time(NULL) ^ GetTickCount64()));
+    if (!seeded) seed = (unsigned int)(time(NULL) ^ GetTickCount64());
+    srand(seed);
+    printf("Seed: %u\n", seed);
     int nextId = 1;
 
     int roadIdx = 0;
 
+    if (highRate) {
+        printf("=== Traffic Generator Started (high-rate) ===\n");
+        printf("Rate: %s\n", rate > 0 ? "fixed" : "unlimited");
+        if (rate > 0) printf("Target: %d vehicles per second\n", rate);
+        printf("Batch: %d records or %dms per flush\n", batchSize, flushMs);
+        printf("Output: %s\n", useSharedRing ? sharedRingName : baseDir);
+        printf("Format: %s\n", useBinaryLog ? "binary log (lane*.bin)" : "ID Name Lane");
+        printf("Backpressure: %s\n", useSharedRing ? "shared ring" : useBackpressure ? backpressureFile : "off");
+        printf("=================================\n\n");
+        run_high_rate(rate, batchSize, flushMs, limit);
+        return 0;
+    }
+
     printf("=== Traffic Generator Started ===\n");
     printf("Interval: %dms\n", interval_ms);
-    printf("Output: %s\n", baseDir);
-    printf("Format: ID Name Lane\n");
+    printf("Output: %s\n", useSharedRing ? sharedRingName : baseDir);
+    printf("Format: %s\n", useBinaryLog ? "binary log (lane*.bin)" : "ID Name Lane");
     printf("Vehicle Spawn Rate: 2 vehicles per second\n");
+    printf("Backpressure: %s\n", useSharedRing ? "shared ring" : useBackpressure ? backpressureFile : "off");
     printf("=================================\n\n");
 
     while (1) {
         int road = roadIdx % 4;
         roadIdx++;
 
+        // The simulator has not caught up with this road yet.
+        if (!road_has_credit(road)) {
+            Sleep(interval_ms);
+            continue;
+        }
+
         int lane = choose_lane_safe(road);
         if (lane == -1) {
             Sleep(interval_ms);
@@ -139,6 +514,7 @@ int main(int argc, char** argv) {
         snprintf(name, sizeof(name), "veh%d", nextId);
 
         if (append_vehicle_to_file(road, nextId, name, lane)) {
+            writtenPerRoad[road]++;
             printf("[%04d] Road %c, Lane %d: %s\n",
                 nextId, 'A' + road, lane, name);
         }